@@ -0,0 +1,183 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Secuencia contigua de hijos guardada en la arena: puntero y largo de 32 bits.
+// Reemplaza a std::list/std::vector en los nodos (sin un nodo de lista por elemento
+// ni capacidad sobrante) y se recorre como un arreglo.
+template <typename T>
+class ArenaList {
+private:
+    T* datos = nullptr;
+    uint32_t n = 0;
+
+public:
+    ArenaList() {}
+    ArenaList(T* d, uint32_t cantidad) : datos(d), n(cantidad) {}
+
+    T* begin() const { return datos; }
+    T* end() const { return datos + n; }
+    size_t size() const { return n; }
+    bool empty() const { return n == 0; }
+    T& operator[](size_t i) const { return datos[i]; }
+    T& front() const { return datos[0]; }
+    T& back() const { return datos[n - 1]; }
+};
+
+// Arena de bloques para los nodos del AST. Reservar es mover un puntero; los
+// nodos creados uno tras otro quedan contiguos. Solo los objetos no triviales
+// (p.ej. un PrintStatement, con sus strings) dejan un registro de su destructor en la
+// propia arena; se ejecutan todos juntos en reset() o al destruirla.
+class Arena {
+private:
+    struct Bloque {
+        char* datos;
+        size_t tam;
+    };
+
+    struct Destructor {
+        void (*destruir)(void*, size_t);
+        void* objeto;
+        size_t cantidad;
+        Destructor* siguiente;
+    };
+
+    static constexpr size_t BLOQUE_INICIAL = 64 * 1024;
+    static constexpr size_t BLOQUE_MAXIMO = 4 * 1024 * 1024;
+
+    std::vector<Bloque> bloques;
+    size_t actual = 0;      // bloque en uso
+    char* cursor = nullptr;
+    char* limite = nullptr;
+    Destructor* destructores = nullptr;
+
+    void nuevoBloque(size_t minimo) {
+        // Reutiliza los bloques que quedaron de un reset antes de pedir memoria.
+        while (bloques.size() > 0 && actual + 1 < bloques.size()) {
+            ++actual;
+            if (bloques[actual].tam >= minimo) {
+                cursor = bloques[actual].datos;
+                limite = cursor + bloques[actual].tam;
+                return;
+            }
+        }
+        size_t tam = bloques.empty() ? BLOQUE_INICIAL : bloques.back().tam * 2;
+        if (tam > BLOQUE_MAXIMO) tam = BLOQUE_MAXIMO;
+        if (tam < minimo) tam = minimo;
+        char* datos = static_cast<char*>(std::malloc(tam));
+        if (!datos) throw std::bad_alloc();
+        bloques.push_back({datos, tam});
+        actual = bloques.size() - 1;
+        cursor = datos;
+        limite = datos + tam;
+    }
+
+    void destruirObjetos() {
+        for (Destructor* d = destructores; d; d = d->siguiente)
+            d->destruir(d->objeto, d->cantidad);
+        destructores = nullptr;
+    }
+
+    template <typename T>
+    void registrarDestructor(T* objetos, size_t cantidad) {
+        if constexpr (!std::is_trivially_destructible<T>::value) {
+            Destructor* d = new (allocate(sizeof(Destructor), alignof(Destructor))) Destructor;
+            d->destruir = [](void* o, size_t k) {
+                for (size_t i = 0; i < k; ++i) static_cast<T*>(o)[i].~T();
+            };
+            d->objeto = objetos;
+            d->cantidad = cantidad;
+            d->siguiente = destructores;
+            destructores = d;
+        }
+    }
+
+public:
+    Arena() {}
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    ~Arena() {
+        destruirObjetos();
+        for (Bloque& b : bloques) std::free(b.datos);
+    }
+
+    void* allocate(size_t bytes, size_t align = alignof(std::max_align_t)) {
+        uintptr_t p = (reinterpret_cast<uintptr_t>(cursor) + align - 1) & ~(uintptr_t)(align - 1);
+        if (!cursor || p + bytes > reinterpret_cast<uintptr_t>(limite)) {
+            nuevoBloque(bytes + align);
+            p = (reinterpret_cast<uintptr_t>(cursor) + align - 1) & ~(uintptr_t)(align - 1);
+        }
+        cursor = reinterpret_cast<char*>(p + bytes);
+        return reinterpret_cast<void*>(p);
+    }
+
+    template <typename T, typename... Args>
+    T* make(Args&&... args) {
+        T* obj = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        registrarDestructor(obj, 1);
+        return obj;
+    }
+
+    // Mueve los elementos a un rango contiguo de la arena.
+    template <typename T>
+    ArenaList<T> list(std::vector<T>&& items) {
+        if (items.empty()) return ArenaList<T>();
+        T* datos = static_cast<T*>(allocate(sizeof(T) * items.size(), alignof(T)));
+        for (size_t i = 0; i < items.size(); ++i) new (datos + i) T(std::move(items[i]));
+        registrarDestructor(datos, items.size());
+        return ArenaList<T>(datos, uint32_t(items.size()));
+    }
+
+    // Pasa a esta arena los bloques y los objetos de otra (p.ej. la de un hilo del parser),
+    // que queda vacía. Los bloques que la otra tenía en uso cuentan como usados aquí hasta
+    // el próximo reset; los que tenía libres quedan libres.
+    void adoptar(Arena& otra) {
+        if (otra.bloques.empty()) return;
+        size_t usados = otra.cursor ? otra.actual + 1 : 0;
+        if (bloques.empty()) {
+            bloques = std::move(otra.bloques);
+            actual = usados ? usados - 1 : 0;
+            cursor = otra.cursor;
+            limite = otra.limite;
+        } else {
+            // Los usados van antes del bloque actual; los libres, al final.
+            bloques.insert(bloques.begin() + actual, otra.bloques.begin(), otra.bloques.begin() + usados);
+            actual += usados;
+            bloques.insert(bloques.end(), otra.bloques.begin() + usados, otra.bloques.end());
+        }
+
+        if (otra.destructores) {
+            Destructor* ultimo = otra.destructores;
+            while (ultimo->siguiente) ultimo = ultimo->siguiente;
+            ultimo->siguiente = destructores;
+            destructores = otra.destructores;
+        }
+
+        otra.bloques.clear();
+        otra.actual = 0;
+        otra.cursor = otra.limite = nullptr;
+        otra.destructores = nullptr;
+    }
+
+    // Libera todos los objetos de una vez y conserva los bloques para la próxima compilación.
+    void reset() {
+        destruirObjetos();
+        actual = 0;
+        if (bloques.empty()) {
+            cursor = limite = nullptr;
+        } else {
+            cursor = bloques[0].datos;
+            limite = cursor + bloques[0].tam;
+        }
+    }
+};
+
+#endif // ARENA_H
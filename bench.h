@@ -0,0 +1,503 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "scanner.h"
+#include "parser.h"
+#include "env.h"
+
+// Benchmarks del front-end. Se invocan desde main con --bench-<fase> [archivo]
+// (--bench-parser, --bench-paralelo, --bench-env, --bench-visitor y --bench-profundidad usan
+// datos sintéticos y no leen el archivo).
+
+namespace bench {
+
+inline double seconds_since(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// Mide fn en un proceso hijo, con un heap recién creado, para que el estado que deja
+// una corrida no afecte a la siguiente.
+template <typename F>
+double time_in_child(F fn) {
+    int fds[2];
+    if (pipe(fds) != 0) return -1;
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(fds[0]);
+        auto t0 = std::chrono::steady_clock::now();
+        fn();
+        double secs = seconds_since(t0);
+        ssize_t w = write(fds[1], &secs, sizeof(secs));
+        _exit(w == sizeof(secs) ? 0 : 1);
+    }
+    close(fds[1]);
+    double secs = -1;
+    if (read(fds[0], &secs, sizeof(secs)) != sizeof(secs)) secs = -1;
+    close(fds[0]);
+    waitpid(pid, nullptr, 0);
+    return secs;
+}
+
+// Repite el fuente hasta tener al menos minBytes para que la medición no sea ruido.
+inline std::string replicate(std::string_view src, size_t minBytes) {
+    std::string out;
+    if (src.empty()) return out;
+    out.reserve(minBytes + src.size());
+    while (out.size() < minBytes) {
+        out.append(src);
+        out.push_back('\n');
+    }
+    return out;
+}
+
+inline size_t scan_once(std::string_view src, Scanner::Mode mode) {
+    SymbolTable simbolos;
+    Scanner sc(src, &simbolos, mode);
+    size_t n = 0;
+    while (sc.nextToken().type != Token::END) ++n;
+    return n;
+}
+
+inline void report(const char* nombre, size_t bytes, size_t tokens, double secs) {
+    std::cout << std::left << std::setw(22) << nombre << std::right << std::fixed << std::setprecision(1)
+              << std::setw(10) << (bytes / 1e6) / secs << " MB/s";
+    if (tokens) std::cout << std::setw(14) << std::setprecision(0) << tokens / secs << " tokens/s";
+    std::cout << "\n";
+}
+
+inline int scanner(std::string_view src) {
+    std::string data = replicate(src, 32u << 20);
+    if (data.empty()) {
+        std::cerr << "bench: fuente vacío" << std::endl;
+        return 1;
+    }
+    std::cout << "Scanner sobre " << data.size() / 1e6 << " MB\n";
+    const Scanner::Mode modos[] = {Scanner::BASIC, Scanner::TABLE};
+    const char* nombres[] = {"basico (isalpha/==)", "tabla+hash+SIMD"};
+    for (int i = 0; i < 2; ++i) {
+        scan_once(data, modos[i]);  // calentamiento
+        auto t0 = std::chrono::steady_clock::now();
+        size_t n = scan_once(data, modos[i]);
+        report(nombres[i], data.size(), n, seconds_since(t0));
+    }
+    return 0;
+}
+
+// Programa sintético cargado de expresiones: literales sueltos, cadenas aritméticas,
+// comparaciones, asignaciones encadenadas e incrementos.
+inline std::string expression_program(int sentencias) {
+    std::string src = "#include<stdio.h>\nint main(){\n int a = 1; int b = 2; int c = 3; int d = 4; long x = 0;\n";
+    const char* plantillas[] = {
+        " x = 7;\n",
+        " x = a + b * (c - d) / 2 - a * b + c;\n",
+        " x = a < b + 1;\n",
+        " a = b = c += d -= 1;\n",
+        " x = -(a + b) * +c - ++a + b-- / (d * (c + (b - a)));\n",
+        " x = a * 2 + b * 3 + c * 4 + d * 5 >= a + b + c + d;\n",
+    };
+    for (int i = 0; i < sentencias; ++i) src += plantillas[i % 6];
+    src += " return 0;\n}\n";
+    return src;
+}
+
+inline int parser() {
+    std::string data = expression_program(60000);
+    std::cout << "Parser de expresiones sobre " << data.size() / 1e6 << " MB sintéticos\n";
+    const Parser::ExprMode modos[] = {Parser::DESCENSO, Parser::PRATT};
+    const char* nombres[] = {"descenso (7 niveles)", "precedencia (Pratt)"};
+    double tiempos[2] = {1e30, 1e30};
+    for (int rep = 0; rep < 5; ++rep) {
+        for (int i = 0; i < 2; ++i) {
+            double t = time_in_child([&] {
+                SymbolTable simbolos;
+                Scanner sc(data, &simbolos);
+                Arena arena;
+                Parser p(&sc, arena, modos[i]);
+                p.parseProgram();
+            });
+            if (t > 0) tiempos[i] = std::min(tiempos[i], t);
+        }
+    }
+    for (int i = 0; i < 2; ++i) report(nombres[i], data.size(), 0, tiempos[i]);
+    std::cout << "Aceleración: " << std::setprecision(2) << tiempos[0] / tiempos[1] << "x\n";
+    return 0;
+}
+
+// Programa sintético con muchas funciones, bloques anidados y llamadas, para medir
+// recorridos completos del AST.
+inline std::string traversal_program(int funciones) {
+    std::string src = "#include<stdio.h>\n";
+    for (int i = 0; i < funciones; ++i) {
+        std::string f = "f" + std::to_string(i);
+        src += "long " + f + "(int a, long b) {\n"
+               " long x = 0; int c = 3;\n"
+               " for (int i = 0; i < a; i++) {\n"
+               "  if (i < c) { x += a * (b - i) / 2 + c; } else { x -= b + i * c - 1; }\n"
+               "  while (c > 0) { c = c - 1; x = x + (a < b) * 7 - -c; }\n"
+               " }\n"
+               " printf(\"%ld\\n\", x + a * b);\n"
+               " return x + a - b * 2;\n}\n";
+    }
+    src += "int main(){\n long t = 0;\n";
+    for (int i = 0; i < funciones; ++i) src += " t += f" + std::to_string(i) + "(3, t + 1);\n";
+    src += " printf(\"%ld\\n\", t);\n return 0;\n}\n";
+    return src;
+}
+
+// Recorrido completo que cuenta nodos y pliega constantes. El mismo código se compila
+// con despacho virtual (accept + visit) o estático (StaticVisitor::dispatch).
+template <bool Estatico>
+class Recorrido final : public Visitor, public StaticVisitor<Recorrido<Estatico>> {
+public:
+    size_t nodos = 0;
+    long suma = 0;
+
+    TypeInfo ir(Exp* e) {
+        if constexpr (Estatico) return this->dispatch(e);
+        else return e->accept(this);
+    }
+    void ir(Stm* s) {
+        if constexpr (Estatico) this->dispatch(s);
+        else s->accept(this);
+    }
+
+    TypeInfo visit(UnaryExp* e) override {
+        ++nodos;
+        if (!e->expr) return TypeInfo(TIPO_INT, 1, false, e->id);
+        TypeInfo t = ir(e->expr);
+        if (e->op == NEG_OP) t.valor = -t.valor;
+        return t;
+    }
+    TypeInfo visit(BinaryExp* e) override {
+        ++nodos;
+        TypeInfo a = ir(e->left);
+        TypeInfo b = ir(e->right);
+        return TypeInfo(promote(a.tipo, b.tipo), a.valor + b.valor, a.isConst && b.isConst);
+    }
+    TypeInfo visit(NumberExp* e) override {
+        ++nodos;
+        return TypeInfo(TIPO_INT, e->value, true);
+    }
+    TypeInfo visit(IdentifierExp* e) override {
+        ++nodos;
+        return TypeInfo(TIPO_LONG, 0, false, e->name);
+    }
+    TypeInfo visit(FCallExp* e) override {
+        ++nodos;
+        for (Exp* a : e->argumentos) ir(a);
+        return TypeInfo(TIPO_LONG, 0, false);
+    }
+    void visit(PrintStatement* s) override {
+        ++nodos;
+        for (Exp* a : s->argumentos) suma += ir(a).valor;
+    }
+    void visit(IfStatement* s) override {
+        ++nodos;
+        suma += ir(s->condition).valor;
+        visit(s->then);
+        if (s->els) visit(s->els);
+    }
+    void visit(WhileStatement* s) override {
+        ++nodos;
+        suma += ir(s->condition).valor;
+        visit(s->b);
+    }
+    void visit(ForStatement* s) override {
+        ++nodos;
+        if (s->varInit) visit(s->varInit);
+        if (s->init) ir(s->init);
+        if (s->cond) suma += ir(s->cond).valor;
+        if (s->update) ir(s->update);
+        visit(s->body);
+    }
+    void visit(ReturnStatement* s) override {
+        ++nodos;
+        if (s->e) suma += ir(s->e).valor;
+    }
+    void visit(VarDec* v) override {
+        ++nodos;
+        for (auto& p : v->vars)
+            if (p.second) suma += ir(p.second).valor;
+    }
+    void visit(Body* b) override {
+        for (Stm* s : b->stms) ir(s);
+    }
+    void visit(FunDec* f) override { visit(f->cuerpo); }
+    void visit(Program* p) override {
+        for (FunDec* f : p->Fundecs) visit(f);
+        visit(p->mainBody);
+    }
+    void visit(ExpressionStatement* s) override {
+        ++nodos;
+        suma += ir(s->expr).valor;
+    }
+};
+
+inline int visitor() {
+    std::string data = traversal_program(500);
+    SymbolTable simbolos;
+    Scanner sc(data, &simbolos);
+    Arena arena;
+    Parser p(&sc, arena);
+    Program* prog = p.parseProgram();
+
+    const int repeticiones = 400;
+    const char* nombres[] = {"virtual (accept+visit)", "estático (CRTP)"};
+    double tiempos[2] = {1e30, 1e30};
+    size_t nodos[2] = {0, 0};
+    long suma[2] = {0, 0};
+    for (int rep = 0; rep < 9; ++rep) {
+        for (int i = 0; i < 2; ++i) {
+            auto t0 = std::chrono::steady_clock::now();
+            for (int r = 0; r < repeticiones; ++r) {
+                if (i == 0) {
+                    Recorrido<false> v;
+                    prog->accept(&v);
+                    nodos[i] = v.nodos;
+                    suma[i] = v.suma;
+                } else {
+                    Recorrido<true> v;
+                    v.visit(prog);
+                    nodos[i] = v.nodos;
+                    suma[i] = v.suma;
+                }
+            }
+            tiempos[i] = std::min(tiempos[i], seconds_since(t0));
+        }
+    }
+    if (nodos[0] != nodos[1] || suma[0] != suma[1]) std::cout << "¡recorridos distintos!\n";
+    std::cout << "Recorrido del AST: " << nodos[0] << " nodos, " << repeticiones << " pasadas\n";
+    for (int i = 0; i < 2; ++i)
+        std::cout << std::left << std::setw(24) << nombres[i] << std::right << std::fixed << std::setprecision(2)
+                  << std::setw(10) << tiempos[i] * 1e9 / (double(nodos[i]) * repeticiones) << " ns/nodo\n";
+    std::cout << "Aceleración: " << std::setprecision(2) << tiempos[0] / tiempos[1] << "x\n";
+    return 0;
+}
+
+// Environment anterior (un unordered_map por nivel, búsqueda de adentro hacia afuera),
+// conservado solo como referencia para --bench-env.
+template <typename T, typename K>
+class RibsEnvironment {
+    std::vector<std::unordered_map<K, T>> ribs;
+
+    int search_rib(K var) {
+        for (int idx = int(ribs.size()) - 1; idx >= 0; --idx)
+            if (ribs[idx].find(var) != ribs[idx].end()) return idx;
+        return -1;
+    }
+
+public:
+    void add_level() { ribs.emplace_back(); }
+    void remove_level() { ribs.pop_back(); }
+    void add_var(K var, T value) { ribs.back()[var] = value; }
+    bool check(K x) { return search_rib(x) >= 0; }
+    T lookup(K x) {
+        int idx = search_rib(x);
+        return idx < 0 ? T() : ribs[idx][x];
+    }
+};
+
+// Recorrido tipo chequeador: abre `profundidad` niveles anidados, declara `porNivel`
+// variables en cada uno (con sombreado) y consulta variables de todos los niveles
+// visibles; después cierra los niveles. Devuelve la cantidad de operaciones.
+template <typename Env, typename Clave, typename Consulta>
+size_t env_walk(Env& env, const std::vector<Clave>& claves, const std::vector<Consulta>& consultas,
+                int profundidad, int porNivel, int consultasPorNivel, long& suma) {
+    size_t ops = 0;
+    size_t c = 0;
+    for (int d = 0; d < profundidad; ++d) {
+        env.add_level();
+        for (int v = 0; v < porNivel; ++v) {
+            env.add_var(claves[(size_t(d) * 7 + v) % claves.size()], TypeInfo(TIPO_LONG, d + v, true));
+            ++ops;
+        }
+        for (int q = 0; q < consultasPorNivel; ++q) {
+            const Consulta& x = consultas[c++ % consultas.size()];
+            if constexpr (std::is_same<Env, RibsEnvironment<TypeInfo, Clave>>::value) {
+                if (env.check(Clave(x))) suma += env.lookup(Clave(x)).valor;  // como el chequeador
+            } else {
+                if (TypeInfo* t = env.find(x)) suma += t->valor;
+            }
+            ++ops;
+        }
+    }
+    for (int d = 0; d < profundidad; ++d) env.remove_level();
+    return ops;
+}
+
+template <typename Nuevo, typename Viejo, typename Clave, typename Consulta>
+void env_case(const char* titulo, const std::vector<Clave>& claves, const std::vector<Consulta>& consultas,
+              int profundidad, int porNivel, int consultasPorNivel, int repeticiones) {
+    std::cout << titulo << "\n";
+    const char* nombres[] = {"ribs (unordered_map)", "plano + deshacer"};
+    double tiempos[2] = {1e30, 1e30};
+    size_t ops = 0;
+    long suma[2] = {0, 0};
+    for (int rep = 0; rep < 3; ++rep) {
+        for (int i = 0; i < 2; ++i) {
+            Viejo viejo;
+            Nuevo nuevo;
+            auto t0 = std::chrono::steady_clock::now();
+            for (int r = 0; r < repeticiones; ++r) {
+                ops = i == 0 ? env_walk(viejo, claves, consultas, profundidad, porNivel, consultasPorNivel, suma[0])
+                             : env_walk(nuevo, claves, consultas, profundidad, porNivel, consultasPorNivel, suma[1]);
+            }
+            tiempos[i] = std::min(tiempos[i], seconds_since(t0));
+        }
+    }
+    if (suma[0] != suma[1]) std::cout << "  ¡resultados distintos!\n";
+    for (int i = 0; i < 2; ++i)
+        std::cout << "  " << std::left << std::setw(22) << nombres[i] << std::right << std::fixed
+                  << std::setprecision(1) << std::setw(10) << tiempos[i] * 1e9 / (double(ops) * repeticiones)
+                  << " ns/op\n";
+    std::cout << "  Aceleración: " << std::setprecision(2) << tiempos[0] / tiempos[1] << "x\n";
+}
+
+inline int env() {
+    const int profundidad = 512, porNivel = 8, consultasPorNivel = 32, repeticiones = 20;
+    std::vector<Symbol> simbolos;
+    std::vector<std::string> nombres;
+    std::vector<std::string_view> vistas;
+    for (int i = 0; i < 2048; ++i) {
+        simbolos.push_back(Symbol(i));
+        nombres.push_back("variable_" + std::to_string(i));
+    }
+    for (const std::string& n : nombres) vistas.push_back(n);
+    // Consultas repartidas entre variables recién declaradas, lejanas y no declaradas.
+    std::vector<Symbol> consultasSym;
+    std::vector<std::string_view> consultasStr;
+    for (int i = 0; i < 4096; ++i) {
+        size_t k = (size_t(i) * 2654435761u) % (profundidad * 7 / 2);
+        consultasSym.push_back(simbolos[k % simbolos.size()]);
+        consultasStr.push_back(vistas[k % vistas.size()]);
+    }
+    std::cout << "Environment: " << profundidad << " niveles anidados, " << porNivel << " variables y "
+              << consultasPorNivel << " consultas por nivel\n";
+    env_case<Environment<TypeInfo, Symbol>, RibsEnvironment<TypeInfo, Symbol>>(
+        "claves Symbol", simbolos, consultasSym, profundidad, porNivel, consultasPorNivel, repeticiones);
+    env_case<Environment<TypeInfo, std::string>, RibsEnvironment<TypeInfo, std::string>>(
+        "claves string (consulta con string_view)", nombres, consultasStr, profundidad, porNivel,
+        consultasPorNivel, repeticiones);
+    return 0;
+}
+
+// Front-end completo (scanner + parser + chequeo de tipos) sobre un programa de muchas
+// funciones: todo secuencial contra parser y chequeo con los cuerpos repartidos en hilos.
+inline int paralelo() {
+    std::string data = traversal_program(8000);
+    std::cout << "Front-end sobre " << data.size() / 1e6 << " MB sintéticos, " << hilosDisponibles()
+              << " núcleo(s)\n";
+    std::vector<unsigned> hilos = {0, 1};  // 0: secuencial
+    unsigned maximo = std::max(4u, hilosDisponibles());
+    for (unsigned h = 2; h <= maximo; h *= 2) hilos.push_back(h);
+    if (hilos.back() != maximo) hilos.push_back(maximo);
+
+    std::vector<double> tiempos(hilos.size(), 1e30);
+    for (int rep = 0; rep < 3; ++rep) {
+        for (size_t i = 0; i < hilos.size(); ++i) {
+            double t = time_in_child([&] {
+                SymbolTable simbolos;
+                Scanner sc(data, &simbolos);
+                Arena arena;
+                Diagnosticos diagnosticos;
+                TypeCheckerVisitor checker(simbolos, diagnosticos);
+                if (hilos[i] == 0) {
+                    Parser p(&sc, arena);
+                    checker.visit(p.parseProgram());
+                } else {
+                    TokenBuffer tokens = sc.scanAll();
+                    Parser p(&sc, arena, tokens, 0, tokens.size() - 1);
+                    checker.chequearParalelo(p.parseProgramParalelo(hilos[i]), hilos[i]);
+                }
+            });
+            if (t > 0) tiempos[i] = std::min(tiempos[i], t);
+        }
+    }
+    for (size_t i = 0; i < hilos.size(); ++i) {
+        std::string nombre = hilos[i] == 0 ? "secuencial" : "cuerpos en " + std::to_string(hilos[i]) + " hilo(s)";
+        report(nombre.c_str(), data.size(), 0, tiempos[i]);
+    }
+    for (size_t i = 2; i < hilos.size(); ++i)
+        std::cout << "Aceleración con " << hilos[i] << " hilos: " << std::setprecision(2) << tiempos[0] / tiempos[i]
+                  << "x\n";
+    return 0;
+}
+
+// Programas con un solo anidamiento de profundidad n, de las tres formas que hacen
+// recursar al parser y a los visitors.
+inline std::string nested_program(const std::string& forma, int n) {
+    std::string src = "#include<stdio.h>\nint main(){\n long x = 0;\n";
+    if (forma == "bloques") {
+        for (int i = 0; i < n; ++i) src += "if (x < 1) {\n";
+        src += "x = x + 1;\n";
+        for (int i = 0; i < n; ++i) src += "}\n";
+    } else if (forma == "cadena") {          // x + 1 + 1 + ...: árbol profundo a la izquierda
+        src += " x = x";
+        for (int i = 0; i < n; ++i) src += " + 1";
+        src += ";\n";
+    } else {                                 // (1 + (1 + (...))): profundo a la derecha
+        src += " x = ";
+        for (int i = 0; i < n; ++i) src += "(1 + ";
+        src += "x";
+        for (int i = 0; i < n; ++i) src += ")";
+        src += ";\n";
+    }
+    src += " printf(\"%ld\\n\", x);\n return 0;\n}\n";
+    return src;
+}
+
+// Prueba de estrés: parsea, chequea y genera código para anidamientos de 10 a 10^6
+// niveles. Falla (devuelve 1) si alguna fase reporta errores; un desborde de pila
+// terminaría el proceso.
+inline int profundidad() {
+    const char* formas[] = {"bloques", "cadena", "parentesis"};
+    bool ok = true;
+    std::cout << std::left << std::setw(12) << "forma" << std::right << std::setw(9) << "niveles"
+              << std::setw(11) << "parser" << std::setw(11) << "chequeo" << std::setw(11) << "codegen" << "\n";
+    for (const char* forma : formas) {
+        for (int n = 10; n <= 1000000; n *= 10) {
+            std::string data = nested_program(forma, n);
+            SymbolTable simbolos;
+            Scanner sc(data, &simbolos);
+            Arena arena;
+            std::ofstream nulo("/dev/null");
+
+            auto t0 = std::chrono::steady_clock::now();
+            Parser p(&sc, arena);
+            Program* prog = p.parseProgram();
+            double tParser = seconds_since(t0);
+
+            t0 = std::chrono::steady_clock::now();
+            Diagnosticos diagnosticos;
+            TypeCheckerVisitor checker(simbolos, diagnosticos);
+            checker.visit(prog);
+            double tChequeo = seconds_since(t0);
+
+            t0 = std::chrono::steady_clock::now();
+            CodeGenVisitor codegen(nulo, simbolos);
+            codegen.generar(prog);
+            double tCodegen = seconds_since(t0);
+
+            bool bien = p.getErrorCount() == 0 && checker.getErrorCount() == 0;
+            ok = ok && bien;
+            std::cout << std::left << std::setw(12) << forma << std::right << std::setw(9) << n << std::fixed
+                      << std::setprecision(3) << std::setw(10) << tParser << "s" << std::setw(10) << tChequeo << "s"
+                      << std::setw(10) << tCodegen << "s" << (bien ? "" : "  FALLÓ") << "\n";
+        }
+    }
+    return ok ? 0 : 1;
+}
+
+} // namespace bench
+
+#endif // BENCH_H
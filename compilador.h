@@ -0,0 +1,162 @@
+#ifndef COMPILADOR_H
+#define COMPILADOR_H
+
+#include <cstdint>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "arena.h"
+#include "diagnosticos.h"
+#include "parser.h"
+#include "scanner.h"
+#include "source.h"
+#include "symbols.h"
+#include "token_buffer.h"
+#include "visitor.h"
+
+// Una compilación completa como biblioteca: fuente en memoria -> assembly y diagnósticos.
+// Todo el estado de una compilación (identificadores, AST, diagnósticos) vive en el
+// Compilador, así que en un mismo proceso pueden correr a la vez tantas compilaciones
+// como Compiladores. Un Compilador se puede reusar: cada compilar empieza de cero y la
+// arena conserva sus bloques. Lo único compartido es la configuración de trazas (traza.h).
+//
+//   Compilador c;
+//   std::string assembly;
+//   if (c.compilar(fuente, assembly) == Compilador::COMPILADO) ...
+//   c.diagnosticos().escribirTexto(std::cout, fuente);
+class Compilador {
+public:
+    struct Opciones {
+        unsigned hilos = 0;  // 0: parser secuencial sobre el scanner; N: front-end y codegen en N hilos
+        bool flujo = false;  // función por función con memoria acotada (ignora hilos)
+    };
+
+    enum Resultado { COMPILADO, ERROR_SINTAXIS, ERROR_TIPOS };
+
+private:
+    Opciones opciones;
+    SymbolTable simbolos;
+    Arena arena;        // el AST; en modo flujo, solo la función en curso
+    Arena arenaFirmas;  // modo flujo: las firmas de la primera pasada
+    Diagnosticos diags;
+
+    Resultado errorDeSintaxis(const Parser& parser) {
+        diags.clear();
+        for (const ErrorSintactico& e : parser.getErrores())
+            diags.agregar(SEV_ERROR, DIAG_SINTAXIS, e.pos, "", e.mensaje);
+        return ERROR_SINTAXIS;
+    }
+
+    // Una primera pasada solo registra las firmas (así se puede llamar a una función
+    // definida más abajo). En la segunda, cada función se parsea, se chequea y se genera
+    // apenas se cierra su '}', y después se liberan sus nodos (la arena vuelve a empezar)
+    // y, si el fuente está mapeado, las páginas ya leídas. La memoria pico depende de la
+    // función más grande, más las firmas y los diagnósticos, y no del tamaño del
+    // archivo. main y el .data van al final; lo demás es igual que en modo normal.
+    Resultado compilarEnFlujo(std::string_view fuente, SourceBuffer* mapeado, std::ostream& salida) {
+        Scanner scannerFirmas(fuente, &simbolos);
+        Parser firmas(&scannerFirmas, arenaFirmas);
+        firmas.saltarCuerpos(true);
+        std::vector<std::string> includes = firmas.parseIncludes();
+        std::vector<FunDec*> funciones;
+        while (firmas.quedanFunciones()) {
+            if (FunDec* f = firmas.parseFunctionRecuperando()) funciones.push_back(f);
+            if (mapeado) mapeado->liberarHasta(firmas.posicionActual());
+        }
+        Program* esqueleto = firmas.parseFinal(std::move(includes), std::move(funciones));
+
+        TypeCheckerVisitor checker(simbolos, diags);
+        checker.registrarFirmas(esqueleto);
+        CodeGenVisitor codegen(salida, simbolos);
+        codegen.iniciarFlujo();
+
+        Scanner scanner(fuente, &simbolos);
+        Parser parser(&scanner, arena);
+        includes = parser.parseIncludes();
+        size_t i = 0;
+        while (parser.quedanFunciones()) {
+            // Después de un error de sintaxis solo se sigue parseando, para reportarlos todos.
+            FunDec* f = parser.parseFunctionRecuperando();
+            if (f && parser.getErrorCount() == 0) {
+                checker.chequearEnFlujo(i++, f);
+                if (checker.getErrorCount() == 0) codegen.generarEnFlujo(f);
+            }
+            arena.reset();
+            if (mapeado) mapeado->liberarHasta(parser.posicionActual());
+        }
+        Program* prog = parser.parseFinal(std::move(includes), {});
+        if (parser.getErrorCount() > 0) return errorDeSintaxis(parser);
+
+        checker.chequearEnFlujo(i, nullptr, prog);
+        if (checker.getErrorCount() > 0) return ERROR_TIPOS;
+        codegen.terminarFlujo(prog);
+        return COMPILADO;
+    }
+
+    Resultado compilar(std::string_view fuente, SourceBuffer* mapeado, std::ostream& salida) {
+        if (fuente.size() > UINT32_MAX)
+            throw std::length_error("el fuente supera los 4 GB que admiten los offsets de token");
+        simbolos.clear();
+        arena.reset();
+        arenaFirmas.reset();
+        diags.clear();
+        if (opciones.flujo) return compilarEnFlujo(fuente, mapeado, salida);
+
+        unsigned hilos = opciones.hilos;
+        Scanner scanner(fuente, &simbolos);
+        TokenBuffer tokens;
+        if (hilos > 0) tokens = scanner.scanAll();
+        Parser parser = hilos > 0 ? Parser(&scanner, arena, tokens, 0, tokens.size() - 1) : Parser(&scanner, arena);
+        Program* prog = hilos > 0 ? parser.parseProgramParalelo(hilos) : parser.parseProgram();
+        if (parser.getErrorCount() > 0) return errorDeSintaxis(parser);
+
+        TypeCheckerVisitor checker(simbolos, diags);
+        if (hilos > 0) checker.chequearParalelo(prog, hilos);
+        else prog->accept(&checker);
+        if (checker.getErrorCount() > 0) return ERROR_TIPOS;
+
+        CodeGenVisitor codegen(salida, simbolos);
+        if (hilos > 0) codegen.generarParalelo(prog, hilos);
+        else codegen.generar(prog);
+        return COMPILADO;
+    }
+
+public:
+    Compilador() {}
+    explicit Compilador(const Opciones& o) : opciones(o) {}
+    Compilador(const Compilador&) = delete;
+    Compilador& operator=(const Compilador&) = delete;
+
+    // Compila `fuente` y escribe el assembly en `salida`. Si no compila, en modo flujo
+    // salida puede haber recibido parte del assembly; en los demás modos no recibe nada.
+    // Lanza std::length_error si el fuente supera los 4 GB; como cualquier biblioteca, también
+    // puede lanzar otras std::exception (std::bad_alloc, ...).
+    Resultado compilar(std::string_view fuente, std::ostream& salida) {
+        return compilar(fuente, nullptr, salida);
+    }
+
+    // Igual, y en modo flujo devuelve al sistema las páginas del fuente ya leídas.
+    Resultado compilar(SourceBuffer& fuente, std::ostream& salida) {
+        return compilar(fuente.view(), &fuente, salida);
+    }
+
+    // El assembly en un string; vacío si no compiló.
+    Resultado compilar(std::string_view fuente, std::string& assembly) {
+        std::ostringstream salida;
+        Resultado r = compilar(fuente, nullptr, salida);
+        assembly = r == COMPILADO ? salida.str() : std::string();
+        return r;
+    }
+
+    // Los de la última compilación: solo los de sintaxis si hubo alguno, si no los del
+    // chequeo de tipos. Las posiciones se ubican con el mismo fuente.
+    const Diagnosticos& diagnosticos() const { return diags; }
+
+    const Opciones& getOpciones() const { return opciones; }
+    void setOpciones(const Opciones& o) { opciones = o; }
+};
+
+#endif // COMPILADOR_H
@@ -0,0 +1,224 @@
+#ifndef DIAGNOSTICOS_H
+#define DIAGNOSTICOS_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Posición en el fuente (offset en bytes) de un nodo o diagnóstico sin ubicación.
+constexpr uint32_t SIN_POSICION = UINT32_MAX;
+
+enum Severidad : uint8_t { SEV_ERROR, SEV_ADVERTENCIA };
+
+enum CodigoDiagnostico : uint8_t {
+    DIAG_SINTAXIS,
+    DIAG_FALTA_STDIO,
+    DIAG_PRINTF_FORMATO,
+    DIAG_PRINTF_ARGUMENTOS,
+    DIAG_PRINTF_TIPO,
+    DIAG_VARIABLE_NO_DECLARADA,
+    DIAG_ASIGNACION_NO_VARIABLE,
+    DIAG_VALOR_NEGATIVO,
+    DIAG_TRUNCAMIENTO,
+    DIAG_FUNCION_NO_EXISTE,
+    DIAG_LLAMADA_ARGUMENTOS,
+    DIAG_LLAMADA_TIPO,
+    DIAG_REDECLARACION,
+    DIAG_NOMBRE_DE_FUNCION,
+    DIAG_INICIALIZACION,
+    DIAG_RETORNO_FALTANTE,
+    DIAG_RETORNO_EN_VOID,
+    DIAG_RETORNO_TIPO,
+    DIAG_REDEFINICION_FUNCION,
+    DIAG_PARAMETROS,
+    DIAG_MAIN_SIN_RETURN,
+    DIAG_CONDICION_FALSA,
+    NUM_CODIGOS
+};
+
+// Nombre estable de cada código, el que se emite en JSON.
+constexpr const char* nombresCodigo[] = {
+    "sintaxis", "falta-stdio", "printf-formato", "printf-argumentos", "printf-tipo",
+    "variable-no-declarada", "asignacion-no-variable", "valor-negativo", "truncamiento",
+    "funcion-no-existe", "llamada-argumentos", "llamada-tipo", "redeclaracion", "nombre-de-funcion",
+    "inicializacion", "retorno-faltante", "retorno-en-void", "retorno-tipo", "redefinicion-funcion",
+    "parametros", "main-sin-return", "condicion-falsa"
+};
+static_assert(sizeof(nombresCodigo) / sizeof(nombresCodigo[0]) == NUM_CODIGOS, "un nombre por código");
+
+// Colector de diagnósticos de una compilación. Cada fase agrega con agregar (se puede
+// llamar desde varios hilos); nada se escribe hasta que el driver llama a
+// escribirTexto o escribirJSON al final. Cada diagnóstico ocupa 24 bytes más sus textos,
+// que van todos seguidos en un único buffer.
+class Diagnosticos {
+public:
+    struct Diagnostico {
+        CodigoDiagnostico codigo;
+        Severidad severidad;
+        uint32_t pos;                    // offset en el fuente, o SIN_POSICION
+        uint32_t funcion, largoFuncion;  // nombre de la función (largo 0: fuera de funciones)
+        uint32_t mensaje, largoMensaje;
+    };
+
+private:
+    mutable std::mutex mutex;
+    std::vector<Diagnostico> lista;
+    std::string textos;
+    int errores = 0, advertencias = 0;
+
+    std::string_view texto(uint32_t inicio, uint32_t largo) const {
+        return std::string_view(textos).substr(inicio, largo);
+    }
+
+    // Línea y columna (desde 1) de cada posición, con el índice de inicios de línea.
+    static std::pair<uint32_t, uint32_t> lineaYColumna(const std::vector<uint32_t>& inicios, uint32_t pos) {
+        size_t i = std::upper_bound(inicios.begin(), inicios.end(), pos) - inicios.begin();
+        return {uint32_t(i), pos - inicios[i - 1] + 1};
+    }
+
+    // Solo hasta el último diagnóstico: el resto del fuente no hace falta leerlo.
+    std::vector<uint32_t> iniciosDeLinea(std::string_view fuente) const {
+        uint32_t ultima = 0;
+        for (const Diagnostico& d : lista)
+            if (d.pos != SIN_POSICION && d.pos <= fuente.size() && d.pos > ultima) ultima = d.pos;
+        fuente = fuente.substr(0, ultima);
+        std::vector<uint32_t> inicios{0};
+        for (const char* p = fuente.data(), *fin = p + fuente.size();
+             (p = static_cast<const char*>(std::memchr(p, '\n', fin - p))); ++p)
+            inicios.push_back(uint32_t(p + 1 - fuente.data()));
+        return inicios;
+    }
+
+    static void escaparJSON(std::string& out, std::string_view s) {
+        for (char c : s) {
+            switch (c) {
+                case '"':  out += "\\\""; break;
+                case '\\': out += "\\\\"; break;
+                case '\n': out += "\\n"; break;
+                case '\t': out += "\\t"; break;
+                default:
+                    if (static_cast<unsigned char>(c) < 0x20) {
+                        char buf[8];
+                        std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+                        out += buf;
+                    } else {
+                        out += c;
+                    }
+            }
+        }
+    }
+
+public:
+    void agregar(Severidad severidad, CodigoDiagnostico codigo, uint32_t pos, std::string_view funcion,
+                 std::string_view mensaje) {
+        std::lock_guard<std::mutex> lock(mutex);
+        Diagnostico d{codigo, severidad, pos, uint32_t(textos.size()), uint32_t(funcion.size()),
+                      uint32_t(textos.size() + funcion.size()), uint32_t(mensaje.size())};
+        textos.append(funcion);
+        textos.append(mensaje);
+        lista.push_back(d);
+        (severidad == SEV_ERROR ? errores : advertencias)++;
+    }
+
+    // Agrega al final, en orden, todo lo que juntó otro colector (p.ej. el de un hilo).
+    void agregarTodos(const Diagnosticos& otro) {
+        std::scoped_lock lock(mutex, otro.mutex);
+        uint32_t base = uint32_t(textos.size());
+        textos += otro.textos;
+        for (Diagnostico d : otro.lista) {
+            d.funcion += base;
+            d.mensaje += base;
+            lista.push_back(d);
+        }
+        errores += otro.errores;
+        advertencias += otro.advertencias;
+    }
+
+    int getErrorCount() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return errores;
+    }
+    int getWarningCount() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return advertencias;
+    }
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return lista.size();
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex);
+        lista.clear();
+        textos.clear();
+        errores = advertencias = 0;
+    }
+
+    // Una línea por diagnóstico, en el orden en que se agregaron:
+    //   Advertencia: En función 'f': <mensaje> (línea 12)
+    void escribirTexto(std::ostream& out, std::string_view fuente) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::vector<uint32_t> inicios = iniciosDeLinea(fuente);
+        std::string s;
+        for (const Diagnostico& d : lista) {
+            s += d.severidad == SEV_ERROR ? "Error: " : "Advertencia: ";
+            if (d.largoFuncion) {
+                s += "En función '";
+                s += texto(d.funcion, d.largoFuncion);
+                s += "': ";
+            }
+            s += texto(d.mensaje, d.largoMensaje);
+            if (d.pos != SIN_POSICION && d.pos <= fuente.size()) {
+                s += " (línea ";
+                s += std::to_string(lineaYColumna(inicios, d.pos).first);
+                s += ')';
+            }
+            s += '\n';
+        }
+        out << s;
+    }
+
+    // {"diagnosticos":[{"codigo":..., "severidad":..., "funcion":..., "linea":..., "columna":...,
+    //   "mensaje":...}], "errores":N, "advertencias":N}. funcion, linea y columna son null
+    // cuando no corresponden.
+    void escribirJSON(std::ostream& out, std::string_view fuente) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::vector<uint32_t> inicios = iniciosDeLinea(fuente);
+        std::string s = "{\"diagnosticos\":[";
+        for (size_t i = 0; i < lista.size(); ++i) {
+            const Diagnostico& d = lista[i];
+            if (i) s += ',';
+            s += "{\"codigo\":\"";
+            s += nombresCodigo[d.codigo];
+            s += "\",\"severidad\":\"";
+            s += d.severidad == SEV_ERROR ? "error" : "advertencia";
+            s += "\",\"funcion\":";
+            if (d.largoFuncion) {
+                s += '"';
+                escaparJSON(s, texto(d.funcion, d.largoFuncion));
+                s += '"';
+            } else {
+                s += "null";
+            }
+            if (d.pos != SIN_POSICION && d.pos <= fuente.size()) {
+                auto lc = lineaYColumna(inicios, d.pos);
+                s += ",\"linea\":" + std::to_string(lc.first) + ",\"columna\":" + std::to_string(lc.second);
+            } else {
+                s += ",\"linea\":null,\"columna\":null";
+            }
+            s += ",\"mensaje\":\"";
+            escaparJSON(s, texto(d.mensaje, d.largoMensaje));
+            s += "\"}";
+        }
+        s += "],\"errores\":" + std::to_string(errores) + ",\"advertencias\":" + std::to_string(advertencias) + "}\n";
+        out << s;
+    }
+};
+
+#endif // DIAGNOSTICOS_H
@@ -1,85 +1,165 @@
 #ifndef ENV
 #define ENV
 
-#include <list>
+#include <cstdint>
+#include <stdexcept>
 #include <string>
-#include <unordered_map>
+#include <string_view>
+#include <type_traits>
+#include <utility>
 #include <vector>
 #include "exp.h"
 #include <iostream>
 
 using namespace std;
 
-template <typename T>
+// Tabla de símbolos con alcance: un único mapa de direccionamiento abierto con la
+// ligadura visible de cada clave, más un registro de deshacer por nivel.
+// add_var guarda en el registro la ligadura que tapa; remove_level restaura solo lo
+// que cambió en ese nivel. Buscar es un sondeo, sin importar la profundidad.
+// Con K = string se puede buscar con string_view sin construir un string.
+template <typename T, typename K = string>
 class Environment {
    private:
-    vector<unordered_map<string, T> > ribs;
-    int search_rib(string var) {
-        int idx = ribs.size() - 1;
-        while (idx >= 0) {
-            typename std::unordered_map<std::string, T>::const_iterator it =
-                ribs[idx].find(var);
-            if (it != ribs[idx].end())
-                return idx;
-            idx--;
+    struct Entrada {
+        K clave;
+        T valor;
+        int nivel;  // nivel donde está ligada; -1 si no hay ligadura visible
+    };
+    struct Cambio {
+        int32_t entrada;
+        int nivelAnterior;
+        T valorAnterior;
+    };
+
+    vector<Entrada> entradas;   // una por clave distinta; los índices no cambian
+    vector<int32_t> tabla;      // índice en entradas o -1; tamaño potencia de 2
+    vector<Cambio> deshacer;
+    vector<size_t> niveles;     // tamaño de deshacer al abrir cada nivel
+
+    template <typename Q>
+    static size_t hashClave(const Q& k) {
+        size_t h;
+        if constexpr (is_convertible<const Q&, string_view>::value)
+            h = std::hash<string_view>()(string_view(k));
+        else
+            h = std::hash<Q>()(k);
+        return h * 0x9E3779B97F4A7C15ull;  // mezcla: las claves enteras son densas
+    }
+
+    size_t posicion(size_t h) const {
+        return h >> (64 - __builtin_ctzll(tabla.size()));
+    }
+
+    template <typename Q>
+    int32_t buscar(const Q& k) const {
+        if (tabla.empty()) return -1;
+        size_t mascara = tabla.size() - 1;
+        for (size_t i = posicion(hashClave(k));; i = (i + 1) & mascara) {
+            int32_t e = tabla[i];
+            if (e < 0 || entradas[e].clave == k) return e;
         }
-        return -1;
+    }
+
+    void crecer() {
+        vector<int32_t> nueva(tabla.empty() ? 64 : tabla.size() * 2, -1);
+        tabla.swap(nueva);
+        size_t mascara = tabla.size() - 1;
+        for (int32_t e = 0; e < (int32_t)entradas.size(); ++e) {
+            size_t i = posicion(hashClave(entradas[e].clave));
+            while (tabla[i] >= 0) i = (i + 1) & mascara;
+            tabla[i] = e;
+        }
+    }
+
+    int32_t obtenerEntrada(const K& k) {
+        int32_t e = buscar(k);
+        if (e >= 0) return e;
+        if ((entradas.size() + 1) * 2 > tabla.size()) crecer();
+        e = int32_t(entradas.size());
+        entradas.push_back({k, T(), -1});
+        size_t mascara = tabla.size() - 1;
+        size_t i = posicion(hashClave(k));
+        while (tabla[i] >= 0) i = (i + 1) & mascara;
+        tabla[i] = e;
+        return e;
     }
 
    public:
     Environment() {}
-    void clear() { ribs.clear(); }
-    void add_level() {
-        unordered_map<string, T> r;
-        ribs.push_back(r);
+    void clear() {
+        entradas.clear();
+        tabla.clear();
+        deshacer.clear();
+        niveles.clear();
     }
-    
-    bool checkCurrentLevel(const string& var) const {
-        if (ribs.empty()) return false;
-        return ribs.back().count(var) > 0;
+    void add_level() { niveles.push_back(deshacer.size()); }
+
+    template <typename Q = K>
+    bool checkCurrentLevel(const Q& var) const {
+        if (niveles.empty()) return false;
+        int32_t e = buscar(var);
+        return e >= 0 && entradas[e].nivel == (int)niveles.size();
     }
 
-    void add_var(string var, T value) {
-        if (ribs.size() == 0) {
-            cout << "Environment sin niveles: no se pueden agregar variables"
-                 << endl;
-            exit(0);
+    void add_var(K var, T value) {
+        if (niveles.size() == 0)
+            throw std::logic_error("Environment sin niveles: no se pueden agregar variables");
+        int32_t e = obtenerEntrada(var);
+        Entrada& en = entradas[e];
+        if (en.nivel != (int)niveles.size()) {
+            deshacer.push_back({e, en.nivel, std::move(en.valor)});
+            en.nivel = (int)niveles.size();
         }
-        ribs.back()[var] = value;
+        en.valor = std::move(value);
     }
-    void add_var(string var) { ribs.back()[var] = 0; }
+    void add_var(K var) { add_var(std::move(var), T(0)); }
 
     bool remove_level() {
-        if (ribs.size() > 0) {
-            ribs.pop_back();
+        if (niveles.size() > 0) {
+            size_t marca = niveles.back();
+            while (deshacer.size() > marca) {
+                Cambio& c = deshacer.back();
+                entradas[c.entrada].nivel = c.nivelAnterior;
+                entradas[c.entrada].valor = std::move(c.valorAnterior);
+                deshacer.pop_back();
+            }
+            niveles.pop_back();
             return true;
         }
         return false;
     }
-    bool update(string x, T v) {
-        int idx = search_rib(x);
-        if (idx < 0)
+
+    // Ligadura visible de x, o nullptr. El puntero vale hasta el próximo add_var.
+    template <typename Q = K>
+    T* find(const Q& x) {
+        int32_t e = buscar(x);
+        return e >= 0 && entradas[e].nivel >= 0 ? &entradas[e].valor : nullptr;
+    }
+
+    template <typename Q = K>
+    bool update(const Q& x, T v) {
+        T* p = find(x);
+        if (!p)
             return false;
-        ribs[idx][x] = v;
+        *p = std::move(v);
         return true;
     }
-    bool check(string x) {
-        int idx = search_rib(x);
-        return (idx >= 0);
+    template <typename Q = K>
+    bool check(const Q& x) {
+        return find(x) != nullptr;
     }
-    T lookup(string x) {
-        T a;
-        int idx = search_rib(x);
-        if (idx < 0)
-            return a;
-        else
-            return ribs[idx][x];
+    template <typename Q = K>
+    T lookup(const Q& x) {
+        T* p = find(x);
+        return p ? *p : T();
     }
-    bool lookup(string x, T& v) {
-        int idx = search_rib(x);
-        if (idx < 0)
+    template <typename Q = K>
+    bool lookup(const Q& x, T& v) {
+        T* p = find(x);
+        if (!p)
             return false;
-        v = ribs[idx][x];
+        v = *p;
         return true;
     }
 };
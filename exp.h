@@ -6,17 +6,23 @@
 #include <list>
 #include <vector>
 #include <stdexcept>
+#include <type_traits>
 #include "visitor.h"
+#include "arena.h"
+#include "symbols.h"
+#include "types.h"
+#include "pila.h"
+#include "diagnosticos.h"
 using namespace std;
 
 struct TypeInfo {
-    std::string tipo;
+    Tipo tipo;
     int valor;
     bool isConst;
-    std::string origen;  
+    Symbol origen;  // variable de la que proviene el valor (NO_SYMBOL si es constante)
 
     bool esTipoSinSigno() const {
-        return tipo == "unsigned" || tipo == "unsigned long";
+        return esSinSigno(tipo);
     }
 
     bool esNegativo() const {
@@ -24,10 +30,15 @@ struct TypeInfo {
     }
 
 
-    TypeInfo(std::string t = "int", int v = 0, bool c = false, std::string o = "")
+    TypeInfo(Tipo t = TIPO_INT, int v = 0, bool c = false, Symbol o = NO_SYMBOL)
         : tipo(t), valor(v), isConst(c), origen(o) {}
 };
 
+struct TypeCheckerVisitor::Variable {
+    TypeInfo info;
+    int slot = 0;
+};
+
 
 
 enum BinaryOp {
@@ -57,26 +68,54 @@ enum UnaryOp {
 
 
 
+// Etiqueta de cada nodo, para distinguirlos con un switch o con node_cast en lugar de RTTI.
+enum ExpKind : uint8_t {
+    UNARY_EXP,
+    BINARY_EXP,
+    NUMBER_EXP,
+    IDENTIFIER_EXP,
+    FCALL_EXP
+};
+
+enum StmKind : uint8_t {
+    WHILE_STM,
+    PRINT_STM,
+    RETURN_STM,
+    EXPRESSION_STM,
+    IF_STM,
+    VARDEC_STM,
+    FOR_STM
+};
+
 class Body;
 
+// Los nodos viven en la Arena y nunca se borran uno por uno, así que Exp y Stm no tienen
+// destructor virtual: sin él los nodos son trivialmente destructibles y la arena no les
+// guarda un registro de destructor (ver los static_assert después de Program).
 class Exp {
 public:
+    const ExpKind kind;
+    explicit Exp(ExpKind k) : kind(k) {}
     virtual TypeInfo accept(Visitor* visitor) = 0;
-    virtual ~Exp() {}
     static char binopToChar(BinaryOp op);
 };
 
 class UnaryExp : public Exp {
 public:
+    static constexpr ExpKind KIND = UNARY_EXP;
     UnaryOp op;
-    std::string id;  
+    Symbol id;  
     Exp* expr;       
+    // Para ++/--, anotados por el chequeo de tipos: tipo declarado y offset en el frame de
+    // la variable (TIPO_NINGUNO y 0 si no está declarada).
+    Tipo tipo = TIPO_NINGUNO;
+    int slot = 0;
 
-    UnaryExp(const std::string& id, UnaryOp op)
-        : op(op), id(id), expr(nullptr) {}
+    UnaryExp(Symbol id, UnaryOp op)
+        : Exp(KIND), op(op), id(id), expr(nullptr) {}
 
     UnaryExp(UnaryOp op, Exp* expr)
-        : op(op), id(""), expr(expr) {}
+        : Exp(KIND), op(op), id(NO_SYMBOL), expr(expr) {}
 
     TypeInfo accept(Visitor* visitor) override;
 };
@@ -85,67 +124,80 @@ public:
 
 class BinaryExp : public Exp {
 public:
+    static constexpr ExpKind KIND = BINARY_EXP;
     Exp *left, *right;
-    std::string type;
     BinaryOp op;
-    BinaryExp(Exp* l, Exp* r, BinaryOp op) : left(l), right(r), op(op) {}
+    BinaryExp(Exp* l, Exp* r, BinaryOp op) : Exp(KIND), left(l), right(r), op(op) {}
     TypeInfo accept(Visitor* visitor) override;
-    ~BinaryExp() override {}
 };
 
 class NumberExp : public Exp {
 public:
+    static constexpr ExpKind KIND = NUMBER_EXP;
     int value;
-    NumberExp(int v) : value(v) {}
+    NumberExp(int v) : Exp(KIND), value(v) {}
     TypeInfo accept(Visitor* visitor) override;
-    ~NumberExp() override {}
 };
 
 class IdentifierExp : public Exp {
 public:
-    std::string name;
-    IdentifierExp(const std::string& n) : name(n) {}
+    static constexpr ExpKind KIND = IDENTIFIER_EXP;
+    Symbol name;
+    // Anotados por el chequeo de tipos, como en UnaryExp.
+    Tipo tipo = TIPO_NINGUNO;
+    int slot = 0;
+    IdentifierExp(Symbol n) : Exp(KIND), name(n) {}
     TypeInfo accept(Visitor* visitor) override;
-    ~IdentifierExp() override {}
 };
 
 class FCallExp : public Exp {
 public:
-    std::string nombre;
-    std::vector<Exp*> argumentos;
-    FCallExp(std::string n, std::vector<Exp*> args) : nombre(n), argumentos(args) {}
+    static constexpr ExpKind KIND = FCALL_EXP;
+    Symbol nombre;
+    ArenaList<Exp*> argumentos;
+    Tipo tipoRetorno = TIPO_NINGUNO;  // anotado por el chequeo de tipos
+    FCallExp(Symbol n, ArenaList<Exp*> args) : Exp(KIND), nombre(n), argumentos(args) {}
     TypeInfo accept(Visitor* visitor) override;
-    ~FCallExp() override {}
 };
 
 
 class Stm {
 public:
+    const StmKind kind;
+    uint32_t pos = SIN_POSICION;  // offset en el fuente de su primer token, para los diagnósticos
+    explicit Stm(StmKind k) : kind(k) {}
     virtual int accept(Visitor* visitor) = 0;
-    virtual ~Stm() {}
 };
 
+// Como dynamic_cast, pero compara la etiqueta: nullptr si el nodo no es un T.
+template <typename T, typename Base>
+T* node_cast(Base* n) {
+    return n && n->kind == T::KIND ? static_cast<T*>(n) : nullptr;
+}
+
 class WhileStatement : public Stm {
 public:
+    static constexpr StmKind KIND = WHILE_STM;
     Exp* condition;
     Body* b;
-    WhileStatement(Exp* condition, Body* b) : condition(condition), b(b) {}
+    WhileStatement(Exp* condition, Body* b) : Stm(KIND), condition(condition), b(b) {}
     int accept(Visitor* visitor) override;
-    ~WhileStatement() override {}
 };
 
 class PrintStatement : public Stm {
 public:
+    static constexpr StmKind KIND = PRINT_STM;
     std::string formato;
-    std::vector<Exp*> argumentos;
-    std::vector<string> bools;
-    PrintStatement(const std::string& f, const std::vector<Exp*>& args) : formato(f), argumentos(args) {}
+    ArenaList<Exp*> argumentos;
+    std::vector<string> bools;             // especificadores tal como aparecen ("d", "lu", ...)
+    std::vector<FormatoPrintf> formatos;   // los mismos, resueltos una vez por el chequeo
+    PrintStatement(const std::string& f, ArenaList<Exp*> args) : Stm(KIND), formato(f), argumentos(args) {}
     int accept(Visitor* visitor) override;
-    ~PrintStatement() override {}
 
 
 
     void countFormatSpecifiers() {
+        bools.clear();
         for (size_t i = 0; i + 1 < formato.size(); ++i) {
             if (formato[i] == '%' && formato[i + 1] != '%') {
                 std::string spec;
@@ -170,49 +222,51 @@ public:
 
 class ReturnStatement : public Stm {
 public:
+    static constexpr StmKind KIND = RETURN_STM;
     Exp* e;
-    ReturnStatement(Exp* e) : e(e) {}
+    ReturnStatement(Exp* e) : Stm(KIND), e(e) {}
     int accept(Visitor* visitor) override;
-    ~ReturnStatement() override {}
 };
 
 
 class ExpressionStatement : public Stm {
 public:
+    static constexpr StmKind KIND = EXPRESSION_STM;
     Exp* expr;
-    ExpressionStatement(Exp* e) : expr(e) {}
+    ExpressionStatement(Exp* e) : Stm(KIND), expr(e) {}
     int accept(Visitor* v) override;
 };
 
 class IfStatement : public Stm {
 public:
+    static constexpr StmKind KIND = IF_STM;
     Exp* condition;
     Body* then;
     Body* els;
-    IfStatement(Exp* condition, Body* then, Body* els) : condition(condition), then(then), els(els) {}
+    IfStatement(Exp* condition, Body* then, Body* els) : Stm(KIND), condition(condition), then(then), els(els) {}
     int accept(Visitor* visitor) override;
-    ~IfStatement() override {}
 };
 
 class VarDec : public Stm {
 public:
-    std::string tipo;
-    std::list<std::pair<std::string, Exp*>> vars;
-    VarDec(std::string tipo, std::list<std::pair<std::string, Exp*>> vars) : tipo(tipo), vars(vars) {}
+    static constexpr StmKind KIND = VARDEC_STM;
+    Tipo tipo;
+    ArenaList<std::pair<Symbol, Exp*>> vars;
+    int slot = 0;  // offset en el frame de la primera variable (anotado); cada una sigue 8 bytes más abajo
+    VarDec(Tipo tipo, ArenaList<std::pair<Symbol, Exp*>> vars) : Stm(KIND), tipo(tipo), vars(vars) {}
     int accept(Visitor* visitor);
-    ~VarDec() {}
 };
 
 class Body {
 public:
-    list<Stm*> stms;
-    Body(list<Stm*> stms) : stms(stms) {}
+    ArenaList<Stm*> stms;
+    Body(ArenaList<Stm*> stms) : stms(stms) {}
     int accept(Visitor* visitor);
-    ~Body() {}
 };
 
 class ForStatement : public Stm {
 public:
+    static constexpr StmKind KIND = FOR_STM;
     VarDec* varInit;     
     Exp* init;          
     Exp* cond;
@@ -220,45 +274,92 @@ public:
     Body* body;
 
     ForStatement(VarDec* vd, Exp* ini, Exp* c, Exp* u, Body* b)
-        : varInit(vd), init(ini), cond(c), update(u), body(b) {}
+        : Stm(KIND), varInit(vd), init(ini), cond(c), update(u), body(b) {}
 
     int accept(Visitor* visitor) override;
-    ~ForStatement() override {
-        delete varInit;
-        delete init;
-        delete cond;
-        delete update;
-        delete body;
-    }
 };
 
 
+// Datos de una función que el parser junta mientras la recorre, para que las fases
+// siguientes no tengan que volver a recorrer el cuerpo.
+struct FunctionSummary {
+    uint32_t locales = 0;      // variables declaradas en el cuerpo, sin contar parámetros
+    uint32_t profundidad = 0;  // anidamiento máximo de bloques (el cuerpo es 1)
+    uint32_t llamadas = 0;     // llamadas a función dentro del cuerpo
+    uint32_t etiquetas = 0;    // if, while y for: cada uno numera sus etiquetas en codegen
+};
+
 class FunDec {
 public:
-    string nombre;
-    string tipo;
-    vector<string> parametros;
-    vector<string> tipos;
+    Symbol nombre;
+    Tipo tipo;
+    ArenaList<Symbol> parametros;
+    ArenaList<Tipo> tipos;
     Body* cuerpo;
-    FunDec(string nombre, string tipo, vector<string> parametros, vector<string> tipos, Body* cuerpo)
-        : nombre(nombre), tipo(tipo), parametros(parametros), tipos(tipos), cuerpo(cuerpo) {}
+    FunctionSummary resumen;
+    uint32_t pos = SIN_POSICION;  // offset del tipo de retorno
+    FunDec(Symbol nombre, Tipo tipo, ArenaList<Symbol> parametros, ArenaList<Tipo> tipos, Body* cuerpo,
+           const FunctionSummary& resumen)
+        : nombre(nombre), tipo(tipo), parametros(parametros), tipos(tipos), cuerpo(cuerpo), resumen(resumen) {}
 
     int accept(Visitor* visitor);
-    ~FunDec() {}
 };
 
 class Program {
 public:
-    list<string> includes;
-    list<FunDec*> Fundecs;
+    ArenaList<string> includes;
+    ArenaList<FunDec*> Fundecs;
     Body* mainBody;
-    Program(list<string> inc, list<FunDec*> funcs, Body* mainBody)
-        : includes(inc), Fundecs(funcs), mainBody(mainBody) {}
+    FunctionSummary resumenMain;
+    uint32_t posMain = SIN_POSICION;
+    Program(ArenaList<string> inc, ArenaList<FunDec*> funcs, Body* mainBody, const FunctionSummary& resumenMain)
+        : includes(inc), Fundecs(funcs), mainBody(mainBody), resumenMain(resumenMain) {}
 
     
 
     int accept(Visitor* visitor);
-    ~Program() {}
 };
 
+// Solo PrintStatement (sus strings y vectores) necesita que la arena lo destruya; los demás
+// nodos quedan contiguos en la arena, sin registros de destructor entre ellos.
+template <typename... Nodos>
+constexpr bool sonTriviales() { return (std::is_trivially_destructible<Nodos>::value && ...); }
+static_assert(sonTriviales<UnaryExp, BinaryExp, NumberExp, IdentifierExp, FCallExp, WhileStatement,
+                           ReturnStatement, ExpressionStatement, IfStatement, VarDec, Body, ForStatement,
+                           FunDec, Program>(),
+              "un nodo del AST dejó de ser trivialmente destructible");
+
+// Todo descenso a un hijo pasa por dispatch, así que es el único lugar donde los
+// visitors chequean la pila (pila::asegurar).
+template <typename Derived>
+inline TypeInfo StaticVisitor<Derived>::dispatch(Exp* e) {
+    Derived& v = static_cast<Derived&>(*this);
+    return pila::asegurar([&]() -> TypeInfo {
+        switch (e->kind) {
+            case UNARY_EXP:      return v.visit(static_cast<UnaryExp*>(e));
+            case BINARY_EXP:     return v.visit(static_cast<BinaryExp*>(e));
+            case NUMBER_EXP:     return v.visit(static_cast<NumberExp*>(e));
+            case IDENTIFIER_EXP: return v.visit(static_cast<IdentifierExp*>(e));
+            case FCALL_EXP:      return v.visit(static_cast<FCallExp*>(e));
+        }
+        return TypeInfo();
+    });
+}
+
+template <typename Derived>
+inline void StaticVisitor<Derived>::dispatch(Stm* s) {
+    Derived& v = static_cast<Derived&>(*this);
+    pila::asegurar([&] {
+        switch (s->kind) {
+            case WHILE_STM:      v.visit(static_cast<WhileStatement*>(s)); break;
+            case PRINT_STM:      v.visit(static_cast<PrintStatement*>(s)); break;
+            case RETURN_STM:     v.visit(static_cast<ReturnStatement*>(s)); break;
+            case EXPRESSION_STM: v.visit(static_cast<ExpressionStatement*>(s)); break;
+            case IF_STM:         v.visit(static_cast<IfStatement*>(s)); break;
+            case VARDEC_STM:     v.visit(static_cast<VarDec*>(s)); break;
+            case FOR_STM:        v.visit(static_cast<ForStatement*>(s)); break;
+        }
+    });
+}
+
 #endif // EXP_H
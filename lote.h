@@ -0,0 +1,173 @@
+#ifndef LOTE_H
+#define LOTE_H
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <sys/stat.h>
+#include "compilador.h"
+#include "paralelo.h"
+#include "source.h"
+
+// Compilación por lotes: muchos fuentes en un solo proceso, repartidos entre hilos con
+// paraleloPara. Cada hilo tiene su Compilador y reusa sus arenas de un archivo al
+// siguiente. Por cada entrada dir/x.txt queda en el directorio de salida x.s si
+// compiló, y x.diag (o x.json con --diagnosticos=json) si tuvo diagnósticos.
+
+namespace lote {
+
+struct Trabajo {
+    std::string entrada;
+    std::string nombre;  // sin directorio ni extensión
+    size_t bytes = 0;
+    Compilador::Resultado resultado = Compilador::ERROR_SINTAXIS;
+    int errores = 0, advertencias = 0;
+    std::string error;  // no se pudo abrir o compilar
+};
+
+// Manifiesto: una ruta por línea; se ignoran las líneas vacías y las que empiezan con '#'.
+inline bool leerLista(const std::string& ruta, std::vector<std::string>& archivos, std::string& err) {
+    std::ifstream in(ruta);
+    if (!in) {
+        err = std::strerror(errno);
+        return false;
+    }
+    std::string linea;
+    while (std::getline(in, linea)) {
+        while (!linea.empty() && (linea.back() == '\r' || linea.back() == ' ')) linea.pop_back();
+        if (!linea.empty() && linea[0] != '#') archivos.push_back(linea);
+    }
+    return true;
+}
+
+inline std::string nombreBase(const std::string& ruta) {
+    size_t barra = ruta.find_last_of('/');
+    std::string nombre = barra == std::string::npos ? ruta : ruta.substr(barra + 1);
+    size_t punto = nombre.find_last_of('.');
+    if (punto != std::string::npos && punto > 0) nombre.resize(punto);
+    return nombre;
+}
+
+inline void compilarUno(Compilador& compilador, Trabajo& t, const std::string& dirSalida, bool json) {
+    SourceBuffer fuente;
+    std::string err;
+    if (!fuente.open(t.entrada, err)) {
+        t.error = "no se pudo abrir: " + err;
+        return;
+    }
+    t.bytes = fuente.size();
+
+    std::string base = dirSalida + "/" + t.nombre;
+    std::string parcial = base + ".s.parcial";
+    std::ofstream salida(parcial);
+    try {
+        t.resultado = compilador.compilar(fuente, salida);
+    } catch (const std::exception& e) {  // un archivo que falla no corta el lote
+        t.error = e.what();
+    }
+    salida.close();
+    if (t.error.empty() && t.resultado == Compilador::COMPILADO) {
+        std::rename(parcial.c_str(), (base + ".s").c_str());
+    } else {
+        std::remove(parcial.c_str());
+        std::remove((base + ".s").c_str());  // que no quede el de una corrida anterior
+    }
+
+    const Diagnosticos& diagnosticos = compilador.diagnosticos();
+    t.errores = diagnosticos.getErrorCount();
+    t.advertencias = diagnosticos.getWarningCount();
+    std::string rutaDiag = base + (json ? ".json" : ".diag");
+    if (diagnosticos.size() > 0) {
+        std::ofstream d(rutaDiag);
+        if (json) diagnosticos.escribirJSON(d, fuente.view());
+        else diagnosticos.escribirTexto(d, fuente.view());
+    } else {
+        std::remove(rutaDiag.c_str());
+    }
+}
+
+// Compila `archivos` en `hilos` hilos y escribe los resultados en dirSalida (se crea si
+// no existe). Al final imprime los archivos que no compilaron y el rendimiento del lote.
+// Devuelve 1 si alguno no se pudo abrir o compilar o tuvo errores de sintaxis, como main con uno solo.
+inline int compilar(const std::vector<std::string>& archivos, const std::string& dirSalida,
+                    const Compilador::Opciones& opciones, unsigned hilos, bool json) {
+    if (mkdir(dirSalida.c_str(), 0777) != 0 && errno != EEXIST) {
+        std::cerr << "No se pudo crear " << dirSalida << ": " << std::strerror(errno) << std::endl;
+        return 1;
+    }
+
+    std::vector<Trabajo> trabajos(archivos.size());
+    std::unordered_map<std::string, size_t> nombres;
+    for (size_t i = 0; i < archivos.size(); ++i) {
+        trabajos[i].entrada = archivos[i];
+        trabajos[i].nombre = nombreBase(archivos[i]);
+        auto repetido = nombres.emplace(trabajos[i].nombre, i);
+        if (!repetido.second) {
+            std::cerr << archivos[repetido.first->second] << " y " << archivos[i]
+                      << " escribirían el mismo " << trabajos[i].nombre << ".s" << std::endl;
+            return 1;
+        }
+    }
+
+    // Los más grandes primero: así ninguno largo empieza cuando los demás hilos ya terminaron.
+    std::vector<size_t> orden(trabajos.size());
+    std::iota(orden.begin(), orden.end(), 0);
+    std::vector<off_t> tam(trabajos.size(), 0);
+    for (size_t i = 0; i < trabajos.size(); ++i) {
+        struct stat st;
+        if (stat(trabajos[i].entrada.c_str(), &st) == 0) tam[i] = st.st_size;
+    }
+    std::stable_sort(orden.begin(), orden.end(), [&](size_t a, size_t b) { return tam[a] > tam[b]; });
+
+    hilos = std::max(1u, std::min<unsigned>(hilos, unsigned(std::max<size_t>(1, trabajos.size()))));
+    Compilador::Opciones porArchivo = opciones;
+    porArchivo.hilos = 0;  // el paralelismo está entre archivos
+    std::vector<std::unique_ptr<Compilador>> compiladores;
+    for (unsigned h = 0; h < hilos; ++h) compiladores.push_back(std::make_unique<Compilador>(porArchivo));
+
+    auto t0 = std::chrono::steady_clock::now();
+    paraleloPara(trabajos.size(), hilos, [&](size_t k, unsigned h) {
+        compilarUno(*compiladores[h], trabajos[orden[k]], dirSalida, json);
+    });
+    double segundos = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    size_t compilados = 0, sintaxis = 0, tipos = 0, fallidos = 0, bytes = 0;
+    for (const Trabajo& t : trabajos) {
+        bytes += t.bytes;
+        if (!t.error.empty()) {
+            ++fallidos;
+            std::cout << t.entrada << ": " << t.error << std::endl;
+        } else if (t.resultado == Compilador::ERROR_SINTAXIS) {
+            ++sintaxis;
+            std::cout << t.entrada << ": " << t.errores << " error(es) de sintaxis" << std::endl;
+        } else if (t.resultado == Compilador::ERROR_TIPOS) {
+            ++tipos;
+            std::cout << t.entrada << ": " << t.errores << " error(es) de tipos" << std::endl;
+        } else {
+            ++compilados;
+        }
+    }
+    double mb = bytes / 1e6;
+    std::cout << trabajos.size() << " archivo(s) en " << hilos << " hilo(s): " << compilados << " compilado(s), "
+              << sintaxis << " con errores de sintaxis, " << tipos << " con errores de tipos, "
+              << fallidos << " que no se pudieron leer o compilar" << std::endl;
+    std::cout << std::fixed << std::setprecision(3) << mb << " MB en " << segundos << " s: "
+              << std::setprecision(1) << (segundos > 0 ? mb / segundos : 0) << " MB/s, "
+              << (segundos > 0 ? trabajos.size() / segundos : 0) << " archivos/s" << std::endl;
+    return fallidos > 0 || sintaxis > 0 ? 1 : 0;
+}
+
+}  // namespace lote
+
+#endif // LOTE_H
@@ -1,65 +1,128 @@
 #include <iostream>
+#include <cstdio>
+#include <exception>
 #include <fstream>
-#include <sstream>
-#include "no_ambigua.h"
-#include "parser.h"
-#include "visitor.h"
-
-
-
-
-
-int main() {
-    std::ifstream file("input.txt");
-    if (!file.is_open()) {
-        std::cerr << "No se pudo abrir input.txt" << std::endl;
+#include "source.h"
+#include "bench.h"
+#include "compilador.h"
+#include "lote.h"
+#include "servidor.h"
+#include "traza.h"
+#include "diagnosticos.h"
+
+
+
+
+
+int main(int argc, char** argv) {
+    // Uso: ./programa [--bench-scanner|--bench-parser|--bench-paralelo|--bench-env|--bench-visitor|--bench-profundidad] [-j[N]] [--traza=CATEGORÍAS[:NIVEL]] [--diagnosticos=texto|json] [--flujo] [--lote=DIR [--lista=ARCHIVO]] [--servidor=RUTA|-] [archivo...]
+    //   (por defecto input.txt; "-" lee de stdin)
+    //   -jN: escanea todo, salta los cuerpos de las funciones y los parsea en N hilos (-j: uno por núcleo);
+    //     el chequeo de tipos y la generación de código también reparten las funciones en N hilos.
+    //   --traza=parser,chequeo / --traza=todo:2: enciende trazas en stderr (categorías scanner, parser,
+    //     chequeo, codegen; nivel 1 o 2, si se compilaron; ver traza.h).
+    //   --diagnosticos=json: stdout es solo un objeto JSON con los errores y advertencias (ver diagnosticos.h).
+    //   --flujo: compila función por función con memoria acotada (ver Compilador); ignora -j.
+    //   --lote=DIR: compila todos los archivos dados (y los de --lista, uno por línea) en -jN hilos
+    //     (por defecto uno por núcleo) y deja x.s, x.diag en DIR (ver lote.h).
+    //   --servidor=RUTA: queda vivo compilando los fuentes que recibe por un socket Unix en RUTA, con
+    //     un pool de -jN hilos; con --servidor=- atiende por stdin/stdout (ver servidor.h).
+    std::string path = "input.txt";
+    std::string benchmark;
+    Compilador::Opciones opciones;
+    bool json = false;
+    std::string dirLote, lista, socketServidor;
+    std::vector<std::string> archivos;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--bench-", 0) == 0) benchmark = arg.substr(8);
+        else if (arg.rfind("--traza=", 0) == 0) {
+            if (!traza::configurar(std::string_view(arg).substr(8))) {
+                std::cerr << "Traza desconocida: " << arg.substr(8) << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--diagnosticos=json" || arg == "--diagnosticos=texto") json = arg == "--diagnosticos=json";
+        else if (arg == "--flujo") opciones.flujo = true;
+        else if (arg.rfind("--lote=", 0) == 0) dirLote = arg.substr(7);
+        else if (arg.rfind("--lista=", 0) == 0) lista = arg.substr(8);
+        else if (arg.rfind("--servidor=", 0) == 0) socketServidor = arg.substr(11);
+        else if (arg.rfind("-j", 0) == 0) opciones.hilos = arg.size() > 2 ? std::max(1, std::atoi(arg.c_str() + 2)) : hilosDisponibles();
+        else archivos.push_back(arg);
+    }
+    if (socketServidor == "-") return servidor::porEntradaEstandar();
+    if (!socketServidor.empty())
+        return servidor::porSocket(socketServidor, opciones.hilos > 0 ? opciones.hilos : hilosDisponibles());
+    if (!dirLote.empty()) {
+        std::string err;
+        if (!lista.empty() && !lote::leerLista(lista, archivos, err)) {
+            std::cerr << "No se pudo abrir " << lista << ": " << err << std::endl;
+            return 1;
+        }
+        unsigned hilos = opciones.hilos > 0 ? opciones.hilos : hilosDisponibles();
+        return lote::compilar(archivos, dirLote, opciones, hilos, json);
+    }
+    if (!archivos.empty()) path = archivos.back();
+    if (benchmark == "parser") return bench::parser();
+    if (benchmark == "paralelo") return bench::paralelo();
+    if (benchmark == "env") return bench::env();
+    if (benchmark == "visitor") return bench::visitor();
+    if (benchmark == "profundidad") return bench::profundidad();
+
+    SourceBuffer source;
+    std::string err;
+    if (!source.open(path, err)) {
+        std::cerr << "No se pudo abrir " << path << ": " << err << std::endl;
         return 1;
     }
 
-    std::stringstream buffer;
-    buffer << file.rdbuf();
-    std::string source = buffer.str();
-
-    Scanner scanner(source.c_str());
-    std::vector<Token*> tokens = scanner.scanAllTokens();
-
-    std::cout << "=== Tokens originales ===\n";
-    for (Token* t : tokens) {
-        std::cout << *t << "\n";
+    if (benchmark == "scanner") return bench::scanner(source.view());
+    if (!benchmark.empty()) {
+        std::cerr << "Benchmark desconocido: " << benchmark << std::endl;
+        return 1;
     }
 
-    no_ambigua(tokens);
-
-    std::cout << "\n=== Tokens después de no_ambigua ===\n";
-    Scanner nuevo_scanner(tokens);
-    for (Token* t : tokens) {
-        std::cout << *t << "\n";
+    // El assembly va a output.s.parcial y pasa a output.s solo si la compilación termina
+    // bien; si no, queda el output.s anterior.
+    const char* parcial = "output.s.parcial";
+    std::ofstream output(parcial);
+    Compilador compilador(opciones);
+    Compilador::Resultado resultado;
+    try {
+        resultado = compilador.compilar(source, output);
+    } catch (const std::exception& e) {  // fuente de más de 4 GB, sin memoria, ...
+        output.close();
+        std::remove(parcial);
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
     }
+    output.close();
+    if (resultado != Compilador::COMPILADO) std::remove(parcial);
+
+    // Los errores y advertencias de todas las fases se muestran una sola vez, al final.
+    const Diagnosticos& diagnosticos = compilador.diagnosticos();
+    auto mostrarDiagnosticos = [&] {
+        if (json) diagnosticos.escribirJSON(std::cout, source.view());
+        else diagnosticos.escribirTexto(std::cout, source.view());
+    };
+
+    if (resultado == Compilador::ERROR_SINTAXIS) {
+        mostrarDiagnosticos();
+        if (!json) std::cout << diagnosticos.getErrorCount() << " error(es) de sintaxis." << std::endl;
+        return 1;
+    }
+    if (!json) std::cout << "\n¡Parseo exitoso!\n";
 
-    Parser parser(&nuevo_scanner);
-
-    Program* prog = parser.parseProgram();
-    std::cout << "\n¡Parseo exitoso!\n";
-
-    TypeCheckerVisitor checker;
-    prog->accept(&checker);
-
-    if (checker.getErrorCount() > 0 || main_count > 1) {
-        if (main_count > 1) {
-            checker.error(std::to_string(main_count) + " funciones 'main' encontradas. Solo se permite una.",0);
-        }
-        std::cout << "El chequeo de tipos falló." << std::endl;
-        exit(0); 
-    } else {
-        std::cout << "Chequeo de tipos exitoso." << std::endl;
+    mostrarDiagnosticos();
+    if (resultado == Compilador::ERROR_TIPOS) {
+        if (!json) std::cout << "El chequeo de tipos falló." << std::endl;
+        return 0;
     }
+    if (!json) std::cout << "Chequeo de tipos exitoso." << std::endl;
 
-    std::cout << "\n=== Generando código ===\n";
-    std::ofstream output("output.s");
-    CodeGenVisitor codegen(output);
-    codegen.generar(prog);  
-    output.close();
-    std::cout << "Código generado en output.s\n";
+    if (!json) std::cout << "\n=== Generando código ===\n";
+    std::rename(parcial, "output.s");
+    if (!json) std::cout << "Código generado en output.s\n";
 
     return 0;
 }
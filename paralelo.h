@@ -0,0 +1,50 @@
+#ifndef PARALELO_H
+#define PARALELO_H
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Hilos que conviene usar por defecto: uno por núcleo.
+inline unsigned hilosDisponibles() {
+    unsigned n = std::thread::hardware_concurrency();
+    return n ? n : 1;
+}
+
+// Ejecuta f(tarea, hilo) para cada tarea de [0, n) repartiéndolas entre `hilos` hilos;
+// el que llama trabaja como hilo 0. Cada hilo toma la próxima tarea libre de un
+// contador compartido, así una tarea larga no deja a los demás esperando. `hilo` está
+// en [0, hilos) y sirve para indexar recursos propios de cada hilo (p.ej. arenas).
+// Si alguna tarea lanza, las que no empezaron se descartan y la excepción se relanza aquí.
+template <typename F>
+void paraleloPara(size_t n, unsigned hilos, F&& f) {
+    if (hilos > n) hilos = unsigned(n);
+    if (hilos <= 1) {
+        for (size_t i = 0; i < n; ++i) f(i, 0u);
+        return;
+    }
+
+    std::atomic<size_t> siguiente{0};
+    std::exception_ptr error;
+    std::mutex mutexError;
+    auto trabajar = [&](unsigned hilo) {
+        try {
+            for (size_t i; (i = siguiente.fetch_add(1, std::memory_order_relaxed)) < n;) f(i, hilo);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutexError);
+            if (!error) error = std::current_exception();
+            siguiente.store(n, std::memory_order_relaxed);
+        }
+    };
+
+    std::vector<std::thread> trabajadores;
+    for (unsigned h = 1; h < hilos; ++h) trabajadores.emplace_back(trabajar, h);
+    trabajar(0);
+    for (std::thread& t : trabajadores) t.join();
+    if (error) std::rethrow_exception(error);
+}
+
+#endif // PARALELO_H
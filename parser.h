@@ -2,21 +2,190 @@
 #define PARSER_H
 
 #include "scanner.h"
+#include "arena.h"
 #include "exp.h"
+#include "pila.h"
+#include "traza.h"
+#include "paralelo.h"
+#include "token_buffer.h"
+#include <algorithm>
+#include <charconv>
 #include <iostream>
+#include <memory>
 #include <stdexcept>
-#include "no_ambigua.h"
+#include <string>
+#include <system_error>
+#include <vector>
 
 using namespace std;
 
+// Error de sintaxis con la posición (offset en el fuente) del token donde se detectó.
+// El parser lo lanza al encontrarlo y lo atrapa en el punto de sincronización más
+// cercano (la sentencia o la declaración global), lo guarda y sigue parseando.
+struct ErrorSintactico {
+    uint32_t pos;
+    std::string mensaje;
+};
+
+// Tabla de operadores binarios para el parser por precedencia (Pratt), indexada por
+// Token::Type. prec 0 = el token no es un operador binario.
+enum Precedencia : uint8_t { PREC_NINGUNA = 0, PREC_ASIGNACION, PREC_RELACIONAL, PREC_ADITIVA, PREC_MULTIPLICATIVA };
+
+struct OperadorBinario {
+    uint8_t prec = PREC_NINGUNA;
+    bool derecha = false;  // asociatividad a la derecha
+    BinaryOp op = PLUS_OP;
+};
+
+struct TablaOperadores {
+    OperadorBinario ops[Token::END + 1];
+    constexpr TablaOperadores() : ops() {
+        ops[Token::ASSING]      = {PREC_ASIGNACION, true, ASSIGN_OP};
+        ops[Token::PLUSASSING]  = {PREC_ASIGNACION, true, PLUS_ASSIGN_OP};
+        ops[Token::MINUSASSING] = {PREC_ASIGNACION, true, MINUS_ASSIGN_OP};
+        ops[Token::LT] = {PREC_RELACIONAL, false, LT_OP};
+        ops[Token::LR] = {PREC_RELACIONAL, false, LE_OP};
+        ops[Token::GT] = {PREC_RELACIONAL, false, GT_OP};
+        ops[Token::GE] = {PREC_RELACIONAL, false, GE_OP};
+        ops[Token::EQ] = {PREC_RELACIONAL, false, EQ_OP};
+        ops[Token::NE] = {PREC_RELACIONAL, false, NE_OP};
+        ops[Token::PLUS]  = {PREC_ADITIVA, false, PLUS_OP};
+        ops[Token::MINUS] = {PREC_ADITIVA, false, MINUS_OP};
+        ops[Token::MULT]  = {PREC_MULTIPLICATIVA, false, MUL_OP};
+        ops[Token::DIV]   = {PREC_MULTIPLICATIVA, false, DIV_OP};
+    }
+};
+
+inline constexpr TablaOperadores tablaOperadores{};
+
 class Parser {
+public:
+    // PRATT: un solo bucle de precedencia sobre tablaOperadores (por defecto).
+    // DESCENSO: la cadena parseAssignExpr -> ... -> parsePrimary; se conserva para el benchmark.
+    enum ExprMode { PRATT, DESCENSO };
+
 private:
     Scanner* scanner;
-    Token *current, *previous;
+    Arena& arena;             // todos los nodos del AST se crean aquí
+    Token current, previous;  // los tokens se piden al scanner a medida que se consumen
+    ExprMode exprMode;
+    FunctionSummary resumen;  // de la función que se está parseando
+    uint32_t profundidad = 0; // bloques abiertos dentro de esa función
+    std::vector<ErrorSintactico> errores;
+
+    // Modo por rangos: los tokens salen de un TokenBuffer ya escaneado y no del scanner,
+    // y más allá de `fin` se lee END. indice es la posición de current en el buffer.
+    const TokenBuffer* tokens = nullptr;
+    size_t pos = 0, fin = 0, indice = 0;
+
+    // Cuerpos que parseProgramParalelo dejó para después: rango [desde, hasta) de sus
+    // tokens sin las llaves. funcion es nulo para main o si la firma quedó incompleta.
+    struct CuerpoPendiente {
+        FunDec* funcion;
+        bool esMain;
+        size_t desde, hasta;
+    };
+    std::vector<CuerpoPendiente>* pendientes = nullptr;
+    bool soloFirmas = false;  // los cuerpos se saltan sin crear nodos (ver saltarCuerpos)
+
+    Token siguiente() {
+        if (!tokens) return scanner->nextToken();
+        indice = pos < fin ? pos++ : fin;
+        if (indice < fin) return (*tokens)[indice];
+        return Token(Token::END, tokens->src().substr(tokens->offset(fin), 0));
+    }
+
+    // Salta el cuerpo que empieza en current contando llaves, sin parsearlo, y lo anota
+    // en pendientes. Deja current en la '}' que lo cierra (o en END).
+    void diferirCuerpo(bool esMain) {
+        size_t i = indice;
+        for (int nivel = 0; i < fin; ++i) {
+            Token::Type t = tokens->type(i);
+            if (t == Token::CD) ++nivel;
+            else if (t == Token::CI && nivel-- == 0) break;
+        }
+        pendientes->push_back({nullptr, esMain, indice, i});
+        pos = i;
+        current = siguiente();
+    }
+
+    // Salta el cuerpo que empieza en current contando llaves, sin crear nodos. Deja
+    // current en la '}' que lo cierra (o en END).
+    void saltarCuerpo() {
+        for (int nivel = 0; !isAtEnd(); advance()) {
+            if (check(Token::CD)) ++nivel;
+            else if (check(Token::CI) && nivel-- == 0) return;
+        }
+    }
+
+    [[noreturn]] void fallar(const std::string& mensaje) {
+        throw ErrorSintactico{scanner->offsetOf(current.text), mensaje};
+    }
+
+    void registrar(const ErrorSintactico& e) { errores.push_back(e); }
+
+    // Los caracteres no reconocidos se reportan y se saltan: el parser nunca ve un ERR.
+    void saltarErrores() {
+        while (current.type == Token::ERR) {
+            registrar({scanner->offsetOf(current.text), "Error de análisis, carácter no reconocido: " + std::string(current.text)});
+            current = siguiente();
+        }
+    }
+
+    static bool esTipo(Token::Type t) {
+        return t == Token::INT || t == Token::LONG || t == Token::UNSIGNED || t == Token::UNSIGNEDL;
+    }
+
+    // Modo pánico dentro de un bloque: descarta tokens hasta el final de la sentencia
+    // rota. Se detiene después de un ';' o de un bloque '{...}' completo, o antes de la
+    // '}' que cierra el bloque actual o de algo que empieza una sentencia.
+    void sincronizar() {
+        int nivel = 0;
+        while (!isAtEnd()) {
+            switch (current.type) {
+                case Token::PC:
+                    if (nivel == 0) { advance(); return; }
+                    break;
+                case Token::CD:
+                    ++nivel;
+                    break;
+                case Token::CI:
+                    if (nivel == 0) return;
+                    if (--nivel == 0) { advance(); return; }
+                    break;
+                case Token::IF: case Token::WHILE: case Token::FOR: case Token::RETURN: case Token::PRINTF:
+                case Token::INT: case Token::LONG: case Token::UNSIGNED: case Token::UNSIGNEDL:
+                    if (nivel == 0) return;
+                    break;
+                default:
+                    break;
+            }
+            advance();
+        }
+    }
+
+    // Modo pánico fuera de las funciones: descarta hasta el próximo include, main o tipo
+    // que empiece una declaración (al principio del archivo o tras '}', ';' o '>'),
+    // saltando los bloques completos que encuentre.
+    void sincronizarGlobal() {
+        int nivel = 0;
+        while (!isAtEnd()) {
+            if (nivel == 0) {
+                if (check(Token::HASH) || check(Token::MAIN)) return;
+                if ((esTipo(current.type) || check(Token::VOID)) &&
+                    (previous.type == Token::END || previous.type == Token::CI ||
+                     previous.type == Token::PC || previous.type == Token::GT))
+                    return;
+            }
+            if (check(Token::CD)) ++nivel;
+            else if (check(Token::CI) && nivel > 0) --nivel;
+            advance();
+        }
+    }
 
     bool match(Token::Type ttype) {
         if (check(ttype)) {
-            std::cout << "[match] Consumido token: " << current->text << " (tipo: " << ttype << ")" << std::endl;
+            TRAZA(PARSER, DETALLE, "[match] Consumido token: " << current.text << " (tipo: " << int(ttype) << ")");
             advance();
             return true;
         }
@@ -25,189 +194,301 @@ private:
 
     bool check(Token::Type ttype) {
         if (isAtEnd()) return false;
-        return current->type == ttype;
+        return current.type == ttype;
     }
 
     bool advance() {
         if (!isAtEnd()) {
-            Token* temp = current;
-            if (previous) delete previous;
-            current = scanner->nextToken();
-            previous = temp;
-            if (check(Token::ERR)) {
-                std::cout << "Error de análisis, carácter no reconocido: " << current->text << std::endl;
-                exit(1);
-            }
+            previous = current;
+            current = siguiente();
+            saltarErrores();
             return true;
         }
         return false;
     }
 
     bool isAtEnd() {
-        return current->type == Token::END;
+        return current.type == Token::END;
     }
 
 public:
 
-    Parser(Scanner* sc): scanner(sc), previous(nullptr) {
-        current = scanner->nextToken();
-        if (current->type == Token::ERR) {
-            std::cout << "Error en el primer token: " << current->text << std::endl;
-            exit(1);
-        }
+    Parser(Scanner* sc, Arena& ar, ExprMode modo = PRATT): scanner(sc), arena(ar), exprMode(modo) {
+        current = siguiente();
+        saltarErrores();
     }
 
+    // Parser sobre los tokens [desde, hasta) de un buffer que sc ya escaneó con scanAll
+    // (sc se usa solo para ubicar líneas). Varios pueden trabajar a la vez sobre el
+    // mismo buffer, cada uno con su arena.
+    Parser(Scanner* sc, Arena& ar, const TokenBuffer& buf, size_t desde, size_t hasta, ExprMode modo = PRATT)
+        : scanner(sc), arena(ar), exprMode(modo), tokens(&buf), pos(desde), fin(hasta) {
+        current = siguiente();
+        saltarErrores();
+    }
+
+    // Errores de sintaxis encontrados, en orden. Si hay alguno, el Program devuelto
+    // por parseProgram está incompleto y no debe pasar a las fases siguientes.
+    const std::vector<ErrorSintactico>& getErrores() const { return errores; }
+    int getErrorCount() const { return int(errores.size()); }
+
     Program* parseProgram() {
-        list<string> includes;
+        std::vector<string> includes = parseIncludes();
+        std::vector<FunDec*> funciones;
+        while (quedanFunciones()) {
+            if (FunDec* f = parseFunctionRecuperando()) funciones.push_back(f);
+        }
+        return parseFinal(std::move(includes), std::move(funciones));
+    }
+
+    // Primera pasada del modo flujo: las funciones quedan sin cuerpo y main vacío. Los
+    // errores que encuentra así los vuelve a encontrar la segunda pasada.
+    void saltarCuerpos(bool si) { soloFirmas = si; }
+
+    // parseProgram por partes, para el modo flujo: parseIncludes, una
+    // parseFunctionRecuperando por función mientras quedanFunciones, y parseFinal.
+    std::vector<string> parseIncludes() {
+        std::vector<string> includes;
         do {
-            includes.push_back(parseInclude());
+            try {
+                includes.push_back(parseInclude());
+            } catch (const ErrorSintactico& e) {
+                registrar(e);
+                sincronizarGlobal();
+            }
         } while (check(Token::HASH));
-        list<FunDec*> funciones;
-        while (check(Token::LONG) || check(Token::VOID) || (check(Token::UNSIGNEDL)) || (check(Token::INT)) || check(Token::UNSIGNED) ) {
-            funciones.push_back(parseFunction());
+        return includes;
+    }
+
+    bool quedanFunciones() {
+        return check(Token::LONG) || check(Token::VOID) || check(Token::UNSIGNEDL) || check(Token::INT) || check(Token::UNSIGNED);
+    }
+
+    // Nulo si la función tiene un error de sintaxis (queda registrado).
+    FunDec* parseFunctionRecuperando() {
+        try {
+            return parseFunction();
+        } catch (const ErrorSintactico& e) {
+            registrar(e);
+            sincronizarGlobal();
+            return nullptr;
         }
+    }
 
-        Body* mainBody = parseMain();
+    // main, el chequeo de cantidad de main y el Program con las funciones dadas.
+    Program* parseFinal(std::vector<string> includes, std::vector<FunDec*> funciones) {
+        // Si la recuperación ya llegó al final, la falta de main es solo una consecuencia.
+        Body* mainBody = nullptr;
+        uint32_t posMain = scanner->offsetOf(current.text);
+        if (errores.empty() || !isAtEnd()) {
+            try {
+                mainBody = parseMain();
+            } catch (const ErrorSintactico& e) {
+                registrar(e);
+            }
+        }
+        if (!mainBody) mainBody = arena.make<Body>(arena.list(std::vector<Stm*>()));
+        FunctionSummary resumenMain = resumen;
+
+        uint32_t posFinal = scanner->offsetOf(current.text);
+        scanner->drain();
+        int main_count = scanner->mainCount();
+        if (main_count > 1) {
+            registrar({posFinal, "Se encontraron " + std::to_string(main_count) + " funciones main(). Debe haber exactamente una."});
+        }
+        Program* prog = arena.make<Program>(arena.list(std::move(includes)), arena.list(std::move(funciones)), mainBody, resumenMain);
+        prog->posMain = posMain;
+        return prog;
+    }
 
-        if (main_count != 1) {
-            std::cerr << "Error: Se encontraron " << main_count << " funciones main(). Debe haber exactamente una." << std::endl;
-            exit(1);
+    // Offset en el fuente del token actual: lo anterior ya no se vuelve a leer.
+    uint32_t posicionActual() const { return scanner->offsetOf(current.text); }
+
+    // Front-end en dos pasadas, para un parser construido sobre el buffer completo
+    // (desde 0 hasta tokens.size() - 1). Primero parsea includes y firmas y salta cada
+    // cuerpo contando llaves; después parsea los cuerpos en `hilos` hilos, cada uno en
+    // su arena, que al final pasan a la arena de este parser. El Program y los errores
+    // son los mismos que con parseProgram.
+    Program* parseProgramParalelo(unsigned hilos) {
+        if (!tokens) return parseProgram();
+        std::vector<CuerpoPendiente> cuerpos;
+        pendientes = &cuerpos;
+        Program* prog = parseProgram();
+        pendientes = nullptr;
+
+        struct Resultado {
+            Body* cuerpo = nullptr;
+            FunctionSummary resumen;
+            std::vector<ErrorSintactico> errores;
+        };
+        std::vector<Resultado> resultados(cuerpos.size());
+        std::vector<std::unique_ptr<Arena>> arenas;
+        for (unsigned h = 0; h < std::max(1u, std::min<unsigned>(hilos, cuerpos.size())); ++h)
+            arenas.push_back(std::make_unique<Arena>());
+
+        paraleloPara(cuerpos.size(), hilos, [&](size_t i, unsigned h) {
+            Parser p(scanner, *arenas[h], *tokens, cuerpos[i].desde, cuerpos[i].hasta, exprMode);
+            resultados[i].cuerpo = p.parseCuerpo(resultados[i].resumen);
+            resultados[i].errores = std::move(p.errores);
+        });
+
+        for (std::unique_ptr<Arena>& a : arenas) arena.adoptar(*a);
+        for (size_t i = 0; i < cuerpos.size(); ++i) {
+            if (cuerpos[i].funcion) {
+                cuerpos[i].funcion->cuerpo = resultados[i].cuerpo;
+                cuerpos[i].funcion->resumen = resultados[i].resumen;
+            } else if (cuerpos[i].esMain) {
+                prog->mainBody = resultados[i].cuerpo;
+                prog->resumenMain = resultados[i].resumen;
+            }
+            errores.insert(errores.end(), resultados[i].errores.begin(), resultados[i].errores.end());
+        }
+        std::stable_sort(errores.begin(), errores.end(),
+                         [](const ErrorSintactico& a, const ErrorSintactico& b) { return a.pos < b.pos; });
+        return prog;
+    }
+
+    // Cuerpo de una función (sin las llaves) que ocupa todo el rango de este parser.
+    Body* parseCuerpo(FunctionSummary& resumenCuerpo) {
+        resumen = FunctionSummary();
+        std::vector<Stm*> stms = parseStatementList();
+        while (!isAtEnd()) {  // una '}' suelta que dejó la recuperación de errores
+            advance();
+            std::vector<Stm*> resto = parseStatementList();
+            stms.insert(stms.end(), resto.begin(), resto.end());
         }
-        return new Program(includes, funciones, mainBody);
+        resumenCuerpo = resumen;
+        return arena.make<Body>(arena.list(std::move(stms)));
     }
 
 
     std::string parseInclude() {
         if (!match(Token::HASH)) {
-            std::cout << "Error: se esperaba '#' al inicio del include.\n";
-            exit(1);
+            fallar("se esperaba '#' al inicio del include.");
         }
 
         if (!match(Token::INCLUDE)) {
-            std::cout << "Error: se esperaba 'include'.\n";
-            exit(1);
+            fallar("se esperaba 'include'.");
         }
         if (!match(Token::LT)) {
-            std::cout << "Error: se esperaba '<' en la declaración de include." << std::endl;
-            exit(1);
+            fallar("se esperaba '<' en la declaración de include.");
         }
 
         if (!match(Token::LIBRARY)) {
-            std::cout << "Error: se esperaba una librería (ej. stdio.h), pero se encontró: " << current->text << std::endl;
-            exit(1);
+            fallar("se esperaba una librería (ej. stdio.h), pero se encontró: " + std::string(current.text));
         }
 
-        std::string lib = previous->text;
+        std::string lib(previous.text);
 
         if (!match(Token::GT)) {
-            std::cout << "Error: se esperaba '>' al final del include." << std::endl;
-            exit(1);
+            fallar("se esperaba '>' al final del include.");
         }
 
         return lib;
     }
 
     FunDec* parseFunction() {
-        std::string tipo;
-        if (match(Token::INT)) tipo = "int";
-        else if (match(Token::LONG)) tipo = "long";
-        else if (match(Token::UNSIGNED)) tipo = "unsigned";
-        else if (match(Token::UNSIGNEDL)) tipo = "unsigned long";
-        else if (match(Token::VOID)) tipo = "void";
+        uint32_t posFuncion = scanner->offsetOf(current.text);
+        Tipo tipo;
+        if (match(Token::INT)) tipo = TIPO_INT;
+        else if (match(Token::LONG)) tipo = TIPO_LONG;
+        else if (match(Token::UNSIGNED)) tipo = TIPO_UNSIGNED;
+        else if (match(Token::UNSIGNEDL)) tipo = TIPO_UNSIGNEDL;
+        else if (match(Token::VOID)) tipo = TIPO_VOID;
         else {
-            std::cout << "Error: se esperaba tipo de retorno válido (int, long, unsigned long, void)." << std::endl;
-            exit(1);
+            fallar("se esperaba tipo de retorno válido (int, long, unsigned long, void).");
         }
 
         if (!match(Token::ID)) {
-            std::cout << "Error: se esperaba identificador para la función." << std::endl;
-            exit(1);
+            fallar("se esperaba identificador para la función.");
         }
-        std::string nombre = previous->text;
+        Symbol nombre = previous.sym;
+        std::string_view textoNombre = previous.text;
 
         if (!match(Token::PI)) {
-            std::cout << "Error: se esperaba '(' tras el nombre de la función." << std::endl;
-            exit(1);
+            fallar("se esperaba '(' tras el nombre de la función.");
         }
 
-        std::vector<std::string> params;
-        std::vector<std::string> tipos;
+        std::vector<Symbol> params;
+        std::vector<Tipo> tipos;
 
         if (!check(Token::PD)) {
             do {
-                std::string tipoParam;
+                Tipo tipoParam;
 
-                if (match(Token::INT)) tipoParam = "int";
-                else if (match(Token::LONG)) tipoParam = "long";
-                else if (match(Token::UNSIGNED)) tipoParam = "unsigned";
-                else if (match(Token::UNSIGNEDL)) tipoParam = "unsigned long";
+                if (match(Token::INT)) tipoParam = TIPO_INT;
+                else if (match(Token::LONG)) tipoParam = TIPO_LONG;
+                else if (match(Token::UNSIGNED)) tipoParam = TIPO_UNSIGNED;
+                else if (match(Token::UNSIGNEDL)) tipoParam = TIPO_UNSIGNEDL;
                 else {
-                    std::cout << "Error: se esperaba tipo de parámetro (int, long, unsigned long)." << std::endl;
-                    exit(1);
+                    fallar("se esperaba tipo de parámetro (int, long, unsigned long).");
                 }
                 tipos.push_back(tipoParam);
 
                 if (!match(Token::ID)) {
-                    std::cout << "Error: se esperaba identificador de parámetro." << std::endl;
-                    exit(1);
+                    fallar("se esperaba identificador de parámetro.");
                 }
-                params.push_back(previous->text);
+                params.push_back(previous.sym);
             } while (match(Token::COMA));
         }
 
         if (!match(Token::PD)) {
-            std::cout << "Error: se esperaba ')' cerrando parámetros." << std::endl;
-            exit(1);
+            fallar("se esperaba ')' cerrando parámetros.");
         }
 
         if (!match(Token::CD)) {
-            std::cout << "Error: se esperaba '{' abriendo el cuerpo de la función." << std::endl;
-            exit(1);
+            fallar("se esperaba '{' abriendo el cuerpo de la función.");
         }
-        cout << *(current) <<endl;
+        TRAZA(PARSER, INFO, "[parseFunction] " << textoNombre << ", cuerpo desde " << current);
 
-        Body* cuerpo = new Body(parseStatementList());
+        resumen = FunctionSummary();
+        Body* cuerpo = nullptr;
+        if (pendientes) diferirCuerpo(false);
+        else if (soloFirmas) saltarCuerpo();
+        else cuerpo = arena.make<Body>(arena.list(parseStatementList()));
 
         if (!match(Token::CI)) {
-            std::cout << "Error: se esperaba '}' cerrando el cuerpo de la función." << std::endl;
-            exit(1);
+            fallar("se esperaba '}' cerrando el cuerpo de la función.");
         }
 
-        return new FunDec(nombre, tipo, params, tipos, cuerpo);
+        FunDec* f = arena.make<FunDec>(nombre, tipo, arena.list(std::move(params)), arena.list(std::move(tipos)), cuerpo, resumen);
+        f->pos = posFuncion;
+        if (pendientes) pendientes->back().funcion = f;
+        return f;
     }
 
     Body* parseMain() {
         if (!match(Token::MAIN)) {
-            std::cout << "Error: se esperaba 'main'. Encontrado: " << current->text << std::endl;
-            exit(1);
+            fallar("se esperaba 'main'. Encontrado: " + std::string(current.text));
         }
 
         if (!match(Token::PI) || !match(Token::PD)) {
-            std::cout << "Error: se esperaba '()' tras 'main'. Encontrado: " << current->text << std::endl;
-            exit(1);
+            fallar("se esperaba '()' tras 'main'. Encontrado: " + std::string(current.text));
         }
 
         if (!match(Token::CD)) {
-            std::cout << "Error: se esperaba '{' al inicio del cuerpo de main. Encontrado: " << current->text << std::endl;
-            exit(1);
+            fallar("se esperaba '{' al inicio del cuerpo de main. Encontrado: " + std::string(current.text));
         }
 
-        list<Stm*> stms = parseStatementList();
+        resumen = FunctionSummary();
+        std::vector<Stm*> stms;
+        if (pendientes) diferirCuerpo(true);
+        else if (soloFirmas) saltarCuerpo();
+        else stms = parseStatementList();
 
         if (!match(Token::CI)) {
-            std::cout << "Error: se esperaba '}' al final de main. Encontrado: " << current->text << std::endl;
-            exit(1);
+            fallar("se esperaba '}' al final de main. Encontrado: " + std::string(current.text));
         }
 
-        return new Body(stms);
+        return arena.make<Body>(arena.list(std::move(stms)));
     }
 
 
-    list<VarDec*> parseVarDecList() {
-        list<VarDec*> vardecs;
+    std::vector<VarDec*> parseVarDecList() {
+        std::vector<VarDec*> vardecs;
 
         while (check(Token::LONG) || check(Token::UNSIGNEDL) || check(Token::UNSIGNED) || check(Token::INT)) {
-            std::cout << "[parseVarDecList] Token actual: " << current->text << std::endl;
+            TRAZA(PARSER, DETALLE, "[parseVarDecList] Token actual: " << current.text);
             vardecs.push_back(parseVarDec());
         }
 
@@ -215,42 +496,37 @@ public:
     }
 
     VarDec* parseVarDec(bool soloUna = false) {
-        std::string tipo;
+        Tipo tipo;
 
-        if (match(Token::INT)) tipo = "int";
-        else if (match(Token::LONG)) tipo = "long";
-        else if (match(Token::UNSIGNED)) tipo = "unsigned";
-        else if (match(Token::UNSIGNEDL)) tipo = "unsigned long";
+        if (match(Token::INT)) tipo = TIPO_INT;
+        else if (match(Token::LONG)) tipo = TIPO_LONG;
+        else if (match(Token::UNSIGNED)) tipo = TIPO_UNSIGNED;
+        else if (match(Token::UNSIGNEDL)) tipo = TIPO_UNSIGNEDL;
         else {
-            std::cout << "Error: se esperaba tipo válido." << std::endl;
-            exit(1);
+            fallar("se esperaba tipo válido.");
         }
 
-        std::list<std::pair<std::string, Exp*>> vars;
+        std::vector<std::pair<Symbol, Exp*>> vars;
 
         if (!match(Token::ID)) {
-            std::cout << "Error: se esperaba nombre de variable." << std::endl;
-            exit(1);
+            fallar("se esperaba nombre de variable.");
         }
 
-        std::string nombre = previous->text;
+        Symbol nombre = previous.sym;
         Exp* valor = nullptr;
 
         if (match(Token::ASSING)) {
-            std::cout << "[DEBUG] Entrando a parseCExp() en declaración de variable" << std::endl;
             valor = parseCExp();
-            std::cout << "[DEBUG] Terminé parseCExp() en declaración de variable" << std::endl;
         }
         vars.push_back({nombre, valor});
 
         if (!soloUna) {
             while (match(Token::COMA)) {
                 if (!match(Token::ID)) {
-                    std::cout << "Error: se esperaba nombre de variable tras ','." << std::endl;
-                    exit(1);
+                    fallar("se esperaba nombre de variable tras ','.");
                 }
 
-                std::string nombreExtra = previous->text;
+                Symbol nombreExtra = previous.sym;
                 Exp* valExtra = nullptr;
                 if (match(Token::ASSING)) {
                     valExtra = parseCExp();
@@ -259,31 +535,50 @@ public:
                 vars.push_back({nombreExtra, valExtra});
             }
         }
-        std::cout << "[DEBUG] Token actual: '" << current->text << "', tipo: " << current->type << std::endl;
+        TRAZA(PARSER, DETALLE, "[parseVarDec] " << vars.size() << " variable(s), sigue '" << current.text << "'");
         if (!match(Token::PC)) {
-            std::cout << "Error: se esperaba ';' al final de la declaración." << std::endl;
-            exit(1);
+            fallar("se esperaba ';' al final de la declaración.");
         }
 
-        return new VarDec(tipo, vars);
+        resumen.locales += vars.size();
+        return arena.make<VarDec>(tipo, arena.list(std::move(vars)));
     }
 
 
-list<Stm*> parseStatementList() {
-    list<Stm*> stms;
-    cout << "[parseStatementList] Iniciando..." << endl;
+// Las tres funciones por las que pasa toda recursión del parser (bloques anidados,
+// operandos derechos y paréntesis/unarios) chequean la pila con pila::asegurar, así
+// que la profundidad de anidamiento queda limitada por el heap.
+std::vector<Stm*> parseStatementList() {
+    return pila::asegurar([&] { return parseStatementListDirecto(); });
+}
+
+std::vector<Stm*> parseStatementListDirecto() {
+    std::vector<Stm*> stms;
+    TRAZA(PARSER, DETALLE, "[parseStatementList] bloque de nivel " << profundidad + 1);
+    if (++profundidad > resumen.profundidad) resumen.profundidad = profundidad;
 
     while (!check(Token::CI) && !isAtEnd()) {
-        if (check(Token::INT) || check(Token::LONG) || check(Token::UNSIGNEDL) || check(Token::UNSIGNED)) {
-            while (check(Token::INT) || check(Token::LONG) || check(Token::UNSIGNEDL) || check(Token::UNSIGNED)) {
-                std::cout << "[parseStatementList] Token actual (declaración): " << current->text << std::endl;
-                stms.push_back(parseVarDec());
+        const char* inicio = current.text.data();
+        try {
+            if (check(Token::INT) || check(Token::LONG) || check(Token::UNSIGNEDL) || check(Token::UNSIGNED)) {
+                while (check(Token::INT) || check(Token::LONG) || check(Token::UNSIGNEDL) || check(Token::UNSIGNED)) {
+                    uint32_t posDec = scanner->offsetOf(current.text);
+                    stms.push_back(parseVarDec());
+                    stms.back()->pos = posDec;
+                }
+            } else {
+                uint32_t posStm = scanner->offsetOf(current.text);
+                stms.push_back(parseStatement());
+                stms.back()->pos = posStm;
             }
-        } else {
-            stms.push_back(parseStatement());
+        } catch (const ErrorSintactico& e) {
+            registrar(e);
+            sincronizar();
+            if (current.text.data() == inicio) advance();  // siempre avanzar al menos un token
         }
     }
 
+    --profundidad;
     return stms;
 }
 
@@ -294,25 +589,23 @@ list<Stm*> parseStatementList() {
         if (check(Token::ID)) {
             Exp* expr = parseCExp();
             if (!match(Token::PC)) {
-                std::cout << "Se esperaba ';' tras la expresión." << std::endl;
-                exit(1);
+                fallar("Se esperaba ';' tras la expresión.");
             }
-            return new ExpressionStatement(expr);
+            return arena.make<ExpressionStatement>(expr);
         }
 
         if (match(Token::PRINTF)) {
 
 
             if (!match(Token::PI)) {
-                std::cout << "Se esperaba '(' tras printf." << std::endl;
-                exit(1);
+                fallar("Se esperaba '(' tras printf.");
             }
 
             std::string formato = "";
             std::vector<Exp*> args;
 
             if (check(Token::STRING)) {
-                formato = current->text;
+                formato = std::string(current.text);
                 match(Token::STRING); 
                 if (check(Token::COMA)) {
                     match(Token::COMA); 
@@ -328,105 +621,94 @@ list<Stm*> parseStatementList() {
                     args.push_back(parseCExp());
                 }
             } else if (formato.empty()) {
-                std::cout << "Se esperaba al menos un argumento o un string en printf." << std::endl;
-                exit(1);
+                fallar("Se esperaba al menos un argumento o un string en printf.");
             }
 
 
             if (!match(Token::PD)) {
-                std::cout << "Se esperaba ')' al final de printf." << std::endl;
-                exit(1);
+                fallar("Se esperaba ')' al final de printf.");
             }
 
             if (!match(Token::PC)) {
-                std::cout << "Se esperaba ';' tras printf." << std::endl;
-                exit(1);
+                fallar("Se esperaba ';' tras printf.");
             }
 
-            return new PrintStatement(formato, args);
+            return arena.make<PrintStatement>(formato, arena.list(std::move(args)));
         }
 
         if (match(Token::IF)) {
+            ++resumen.etiquetas;
             if (!match(Token::PI)) {
-                std::cout << "Se esperaba '(' tras 'if'." << std::endl;
-                exit(1);
+                fallar("Se esperaba '(' tras 'if'.");
             }
 
             Exp* condition = parseCExp();
 
             if (!match(Token::PD)) {
-                std::cout << "Se esperaba ')' cerrando condición del 'if'." << std::endl;
-                exit(1);
+                fallar("Se esperaba ')' cerrando condición del 'if'.");
             }
 
             if (!match(Token::CD)) {
-                std::cout << "Se esperaba '{' para abrir el bloque del 'if'." << std::endl;
-                exit(1);
+                fallar("Se esperaba '{' para abrir el bloque del 'if'.");
             }
 
-            list<Stm*> stmsThen = parseStatementList();
+            std::vector<Stm*> stmsThen = parseStatementList();
 
             if (!match(Token::CI)) {
-                std::cout << "Se esperaba '}' cerrando bloque del 'if'." << std::endl;
-                exit(1);
+                fallar("Se esperaba '}' cerrando bloque del 'if'.");
             }
 
-            Body* thenBody = new Body(stmsThen);
+            Body* thenBody = arena.make<Body>(arena.list(std::move(stmsThen)));
             Body* elseBody = nullptr;
 
             if (match(Token::ELSE)) {
                 if (!match(Token::CD)) {
-                    std::cout << "Se esperaba '{' para abrir el bloque del 'else'." << std::endl;
-                    exit(1);
+                    fallar("Se esperaba '{' para abrir el bloque del 'else'.");
                 }
 
-                list<Stm*> stmsElse = parseStatementList();
+                std::vector<Stm*> stmsElse = parseStatementList();
 
                 if (!match(Token::CI)) {
-                    std::cout << "Se esperaba '}' cerrando bloque del 'else'." << std::endl;
-                    exit(1);
+                    fallar("Se esperaba '}' cerrando bloque del 'else'.");
                 }
 
-                elseBody = new Body(stmsElse);
+                elseBody = arena.make<Body>(arena.list(std::move(stmsElse)));
             }
 
-            return new IfStatement(condition, thenBody, elseBody);
+            return arena.make<IfStatement>(condition, thenBody, elseBody);
         }
 
         if (match(Token::WHILE)) {
+            ++resumen.etiquetas;
             if (!match(Token::PI)) {
-                std::cout << "Se esperaba '(' tras 'while'." << std::endl;
-                exit(1);
+                fallar("Se esperaba '(' tras 'while'.");
             }
 
             Exp* condition = parseCExp();
 
             if (!match(Token::PD)) {
-                std::cout << "Se esperaba ')' cerrando condición del 'while'." << std::endl;
-                exit(1);
+                fallar("Se esperaba ')' cerrando condición del 'while'.");
             }
 
             if (!match(Token::CD)) {
-                std::cout << "Se esperaba '{' abriendo el cuerpo del 'while'." << std::endl;
-                exit(1);
+                fallar("Se esperaba '{' abriendo el cuerpo del 'while'.");
             }
 
-            list<Stm*> stms = parseStatementList();
+            std::vector<Stm*> stms = parseStatementList();
 
             if (!match(Token::CI)) {
-                std::cout << "Se esperaba '}' cerrando el cuerpo del 'while'." << std::endl;
-                exit(1);
+                fallar("Se esperaba '}' cerrando el cuerpo del 'while'.");
             }
 
-            Body* cuerpo = new Body(stms);
-            return new WhileStatement(condition, cuerpo);
+            Body* cuerpo = arena.make<Body>(arena.list(std::move(stms)));
+            return arena.make<WhileStatement>(condition, cuerpo);
         }
 
 
         if (match(Token::FOR)) {
+            ++resumen.etiquetas;
             if (!match(Token::PI)) {
-                std::cout << "Se esperaba '(' tras 'for'." << std::endl;
-                exit(1);
+                fallar("Se esperaba '(' tras 'for'.");
             }
 
             VarDec* varInit = nullptr;
@@ -437,77 +719,100 @@ list<Stm*> parseStatementList() {
             } else {
                 expInit = parseCExp();
                 if (!match(Token::PC)) {
-                    std::cout << "Se esperaba ';' después de la inicialización en 'for'." << std::endl;
-                    exit(1);
+                    fallar("Se esperaba ';' después de la inicialización en 'for'.");
                 }
             }
 
             Exp* cond = parseCExp();
             if (!match(Token::PC)) {
-                std::cout << "Se esperaba ';' después de la condición del for." << std::endl;
-                exit(1);
+                fallar("Se esperaba ';' después de la condición del for.");
             }
 
             Exp* update = parseCExp();
             if (!match(Token::PD)) {
-                std::cout << "Se esperaba ')' cerrando la cabecera del for." << std::endl;
-                exit(1);
+                fallar("Se esperaba ')' cerrando la cabecera del for.");
             }
 
             if (!match(Token::CD)) {
-                std::cout << "Se esperaba '{' abriendo el cuerpo del for." << std::endl;
-                exit(1);
+                fallar("Se esperaba '{' abriendo el cuerpo del for.");
             }
 
-            std::list<Stm*> stms = parseStatementList();
+            std::vector<Stm*> stms = parseStatementList();
 
             if (!match(Token::CI)) {
-                std::cout << "Se esperaba '}' cerrando el cuerpo del for." << std::endl;
-                exit(1);
+                fallar("Se esperaba '}' cerrando el cuerpo del for.");
             }
 
-            Body* cuerpo = new Body(stms);
-            return new ForStatement(varInit, expInit, cond, update, cuerpo);
+            Body* cuerpo = arena.make<Body>(arena.list(std::move(stms)));
+            return arena.make<ForStatement>(varInit, expInit, cond, update, cuerpo);
         }
 
         if (match(Token::RETURN)) {
             Exp* e = parseCExp();
             
             if (!match(Token::PC)) {
-                std::cout << "Se esperaba ';' después de return." << std::endl;
-                exit(1);
+                fallar("Se esperaba ';' después de return.");
             }
 
-            return new ReturnStatement(e);
+            return arena.make<ReturnStatement>(e);
         }
 
 
-        std::cout << "Error: statement desconocido." << std::endl;
-        exit(1);
-        return nullptr;  
+        fallar("statement desconocido.");
 
     }
 
 
     Exp* parseCExp() {
-        return parseAssignExpr();
+        bool esId;
+        return parseCExp(esId);
+    }
+
+    // esId indica si la expresión es un identificador solo (o entre paréntesis),
+    // lo único que puede ir a la izquierda de una asignación.
+    Exp* parseCExp(bool& esId) {
+        if (exprMode == PRATT) return parseExpr(PREC_ASIGNACION, esId);
+        Exp* e = parseAssignExpr();
+        esId = e->kind == IDENTIFIER_EXP;
+        return e;
+    }
+
+    Exp* parseExpr(int minPrec, bool& esId) {
+        return pila::asegurar([&] { return parseExprDirecto(minPrec, esId); });
+    }
+
+    Exp* parseExprDirecto(int minPrec, bool& esId) {
+        Exp* left = parseUnaryExpr(esId);
+
+        while (true) {
+            const OperadorBinario& info = tablaOperadores.ops[current.type];
+            if (info.prec == PREC_NINGUNA || info.prec < minPrec) break;
+            if (info.prec == PREC_ASIGNACION && !esId) break;
+            advance();
+            bool derechaEsId;
+            Exp* right = parseExpr(info.derecha ? info.prec : info.prec + 1, derechaEsId);
+            left = arena.make<BinaryExp>(left, right, info.op);
+            esId = false;
+        }
+
+        return left;
     }
 
     Exp* parseAssignExpr() {
         Exp* left = parseRelExpr();
 
-        if (auto idExp = dynamic_cast<IdentifierExp*>(left)) {
+        if (left->kind == IDENTIFIER_EXP) {
             if (match(Token::ASSING)) {
                 Exp* right = parseAssignExpr();  // recursivo
-                return new BinaryExp(left, right, ASSIGN_OP);
+                return arena.make<BinaryExp>(left, right, ASSIGN_OP);
             }
             if (match(Token::PLUSASSING)) {
                 Exp* right = parseAssignExpr();  // recursivo
-                return new BinaryExp(left, right, PLUS_ASSIGN_OP);
+                return arena.make<BinaryExp>(left, right, PLUS_ASSIGN_OP);
             }
             if (match(Token::MINUSASSING)) {
                 Exp* right = parseAssignExpr();  // recursivo
-                return new BinaryExp(left, right, MINUS_ASSIGN_OP);
+                return arena.make<BinaryExp>(left, right, MINUS_ASSIGN_OP);
             }
         }
 
@@ -520,23 +825,22 @@ list<Stm*> parseStatementList() {
         while (check(Token::LT) || check(Token::LR) || check(Token::GT) || 
             check(Token::GE) || check(Token::EQ) || check(Token::NE)) {
             
-            Token::Type opType = current->type;
+            Token::Type opType = current.type;
             advance();
             BinaryOp op;
             switch (opType) {
-                case Token::LT: op = LT_OP; cout << "mega kaka" << endl; break;
+                case Token::LT: op = LT_OP; break;
                 case Token::LR: op = LE_OP; break;
                 case Token::GT: op = GT_OP; break;
                 case Token::GE: op = GE_OP; break;
                 case Token::EQ: op = EQ_OP; break;
                 case Token::NE: op = NE_OP; break;
                 default:
-                    std::cout << "Error: operador relacional no esperado.\n";
-                    exit(1);
+                    fallar("operador relacional no esperado.");
             }
 
             Exp* right = parseAddExpr();
-            left = new BinaryExp(left, right, op);
+            left = arena.make<BinaryExp>(left, right, op);
         }
 
         return left;
@@ -548,9 +852,9 @@ list<Stm*> parseStatementList() {
         Exp* left = parseMulExpr();
 
         while (match(Token::PLUS) || match(Token::MINUS)) {
-            BinaryOp op = previous->type == Token::PLUS ? PLUS_OP : MINUS_OP;
+            BinaryOp op = previous.type == Token::PLUS ? PLUS_OP : MINUS_OP;
             Exp* right = parseMulExpr();
-            left = new BinaryExp(left, right, op);
+            left = arena.make<BinaryExp>(left, right, op);
         }
 
         return left;
@@ -558,12 +862,13 @@ list<Stm*> parseStatementList() {
 
 
     Exp* parseMulExpr() {
-        Exp* left = parseUnaryExpr();
+        bool esId;
+        Exp* left = parseUnaryExpr(esId);
 
         while (match(Token::MULT) || match(Token::DIV)) {
-            BinaryOp op = previous->type == Token::MULT ? MUL_OP : DIV_OP;
-            Exp* right = parseUnaryExpr();
-            left = new BinaryExp(left, right, op);
+            BinaryOp op = previous.type == Token::MULT ? MUL_OP : DIV_OP;
+            Exp* right = parseUnaryExpr(esId);
+            left = arena.make<BinaryExp>(left, right, op);
         }
 
         return left;
@@ -571,41 +876,54 @@ list<Stm*> parseStatementList() {
 
 
 
-    Exp* parseUnaryExpr() {
+    Exp* parseUnaryExpr(bool& esId) {
+        esId = false;
         if (match(Token::INCRE)) {
             if (!match(Token::ID)) {
-                std::cout << "Error: se esperaba identificador después de ++\n";
-                exit(1);
+                fallar("se esperaba identificador después de ++");
             }
-            return new UnaryExp(previous->text, PRE_INC_OP);
+            return arena.make<UnaryExp>(previous.sym, PRE_INC_OP);
         }
 
         if (match(Token::DECRE)) {
             if (!match(Token::ID)) {
-                std::cout << "Error: se esperaba identificador después de --\n";
-                exit(1);
+                fallar("se esperaba identificador después de --");
             }
-            return new UnaryExp(previous->text, PRE_DEC_OP);
+            return arena.make<UnaryExp>(previous.sym, PRE_DEC_OP);
         }
 
-        return parsePrimary(); 
+        return parsePrimary(esId); 
     }
 
 
-    Exp* parsePrimary() {
+    Exp* parsePrimary(bool& esId) {
+        return pila::asegurar([&] { return parsePrimaryDirecto(esId); });
+    }
+
+    Exp* parsePrimaryDirecto(bool& esId) {
+        esId = false;
         if (match(Token::PLUS)) {
-            Exp* sub = parsePrimary();
-            return new UnaryExp(POS_OP, sub);
+            Exp* sub = parsePrimary(esId);
+            esId = false;
+            return arena.make<UnaryExp>(POS_OP, sub);
         }
         if (match(Token::MINUS)) {
-            Exp* sub = parsePrimary();
-            return new UnaryExp(NEG_OP, sub);
+            Exp* sub = parsePrimary(esId);
+            esId = false;
+            return arena.make<UnaryExp>(NEG_OP, sub);
         }
         if (match(Token::NUM)) {
-            return new NumberExp(std::stoi(previous->text));
+            // NumberExp guarda un int: un literal que no entra es un error de sintaxis más.
+            int valor = 0;
+            const char* fin = previous.text.data() + previous.text.size();
+            auto r = std::from_chars(previous.text.data(), fin, valor);
+            if (r.ec != std::errc() || r.ptr != fin)
+                throw ErrorSintactico{scanner->offsetOf(previous.text),
+                                      "literal entero fuera de rango: " + std::string(previous.text)};
+            return arena.make<NumberExp>(valor);
         }
         if (match(Token::ID)) {
-            std::string id = previous->text;
+            Symbol id = previous.sym;
 
             if (match(Token::PI)) {
                 std::vector<Exp*> args;
@@ -615,33 +933,32 @@ list<Stm*> parseStatementList() {
                     } while (match(Token::COMA));
                 }
                 if (!match(Token::PD)) {
-                    std::cout << "Error: se esperaba ')' cerrando llamada a función.\n";
-                    exit(1);
+                    fallar("se esperaba ')' cerrando llamada a función.");
                 }
-                return new FCallExp(id, args);
+                ++resumen.llamadas;
+                return arena.make<FCallExp>(id, arena.list(std::move(args)));
             }
 
             if (match(Token::INCRE)) {
-                return new UnaryExp(id, POST_INC_OP);
+                return arena.make<UnaryExp>(id, POST_INC_OP);
             }
             if (match(Token::DECRE)) {
-                return new UnaryExp(id, POST_DEC_OP);
+                return arena.make<UnaryExp>(id, POST_DEC_OP);
             }
 
-            return new IdentifierExp(id);
+            esId = true;
+            return arena.make<IdentifierExp>(id);
         }
 
         if (match(Token::PI)) {
-            Exp* e = parseCExp();
+            Exp* e = parseCExp(esId);
             if (!match(Token::PD)) {
-                std::cout << "Error: se esperaba ')' cerrando expresión.\n";
-                exit(1);
+                fallar("se esperaba ')' cerrando expresión.");
             }
             return e;
         }
 
-        std::cout << "Error: expresión primaria inválida.\n";
-        exit(1);
+        fallar("expresión primaria inválida.");
     }
 
 
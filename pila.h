@@ -0,0 +1,161 @@
+#ifndef PILA_H
+#define PILA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <ucontext.h>
+
+#if defined(__SANITIZE_ADDRESS__)
+#include <sanitizer/common_interface_defs.h>
+// ASan necesita saber en qué pila está; si no, las excepciones que cruzan un
+// segmento dan falsos positivos.
+#define PILA_ASAN 1
+#endif
+
+// Recursión acotada por el heap y no por la pila nativa. El parser y los visitors son
+// recursivos (un nivel por bloque, paréntesis o operando); asegurar(f) llama a f
+// directamente mientras quede pila, y si quedan menos de MARGEN bytes la ejecuta en
+// un segmento nuevo reservado con mmap. Al volver, el segmento queda para reusar.
+// Las excepciones que salen de f se vuelven a lanzar del lado de quien llamó.
+namespace pila {
+
+constexpr size_t MARGEN = 256 * 1024;        // lo que puede usar un nivel entre dos chequeos
+constexpr size_t SEGMENTO = 4 * 1024 * 1024;
+constexpr size_t SEGMENTOS_GUARDADOS = 16;   // el resto se devuelve al sistema
+constexpr size_t PILA_SUPUESTA = 1024 * 1024;  // si no se puede saber el tamaño de la pila del hilo
+
+struct Hilo {
+    uintptr_t limite = 0;        // dirección más baja utilizable de la pila actual
+    std::vector<void*> libres;   // segmentos ya reservados, sin usar
+
+    Hilo() {
+        pthread_attr_t attr;
+        void* base;
+        size_t tam;
+        if (pthread_getattr_np(pthread_self(), &attr) == 0) {
+            if (pthread_attr_getstack(&attr, &base, &tam) == 0) limite = uintptr_t(base);
+            pthread_attr_destroy(&attr);
+        }
+        if (limite == 0) {
+            // Sin los atributos del hilo se supone que quedan PILA_SUPUESTA bytes (o el
+            // RLIMIT_STACK, si es menor) debajo de este punto; con limite en 0, asegurar
+            // nunca cambiaría de segmento.
+            char marca;
+            size_t disponible = PILA_SUPUESTA;
+            struct rlimit rl;
+            if (getrlimit(RLIMIT_STACK, &rl) == 0 && rl.rlim_cur != RLIM_INFINITY && rl.rlim_cur < disponible)
+                disponible = rl.rlim_cur;
+            limite = uintptr_t(&marca) > disponible ? uintptr_t(&marca) - disponible : 0;
+        }
+    }
+    ~Hilo() {
+        for (void* s : libres) munmap(s, SEGMENTO);
+    }
+};
+
+inline Hilo& hilo() {
+    thread_local Hilo h;
+    return h;
+}
+
+struct Llamada {
+    void (*cuerpo)(void*);
+    void* arg;
+    std::exception_ptr error;
+    ucontext_t volver;
+#ifdef PILA_ASAN
+    const void* baseAnterior = nullptr;
+    size_t tamAnterior = 0;
+#endif
+};
+
+inline thread_local Llamada* llamadaActual = nullptr;
+
+inline void trampolin() {
+    Llamada* ll = llamadaActual;
+#ifdef PILA_ASAN
+    __sanitizer_finish_switch_fiber(nullptr, &ll->baseAnterior, &ll->tamAnterior);
+#endif
+    try {
+        ll->cuerpo(ll->arg);
+    } catch (...) {
+        ll->error = std::current_exception();
+    }
+#ifdef PILA_ASAN
+    __sanitizer_start_switch_fiber(nullptr, ll->baseAnterior, ll->tamAnterior);
+#endif
+}  // uc_link vuelve a ll->volver
+
+inline void enSegmento(void (*cuerpo)(void*), void* arg) {
+    Hilo& h = hilo();
+    void* seg;
+    if (h.libres.empty()) {
+        seg = mmap(nullptr, SEGMENTO, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+        if (seg == MAP_FAILED) throw std::bad_alloc();
+    } else {
+        seg = h.libres.back();
+        h.libres.pop_back();
+    }
+
+    Llamada ll{};
+    ll.cuerpo = cuerpo;
+    ll.arg = arg;
+    ucontext_t ctx;
+    getcontext(&ctx);
+    ctx.uc_stack.ss_sp = seg;
+    ctx.uc_stack.ss_size = SEGMENTO;
+    ctx.uc_link = &ll.volver;
+    makecontext(&ctx, trampolin, 0);
+
+    uintptr_t limiteAnterior = h.limite;
+    Llamada* anterior = llamadaActual;
+    h.limite = uintptr_t(seg);
+    llamadaActual = &ll;
+#ifdef PILA_ASAN
+    void* falsaPila = nullptr;
+    __sanitizer_start_switch_fiber(&falsaPila, seg, SEGMENTO);
+#endif
+    swapcontext(&ll.volver, &ctx);
+#ifdef PILA_ASAN
+    __sanitizer_finish_switch_fiber(falsaPila, nullptr, nullptr);
+#endif
+    llamadaActual = anterior;
+    h.limite = limiteAnterior;
+
+    if (h.libres.size() < SEGMENTOS_GUARDADOS) h.libres.push_back(seg);
+    else munmap(seg, SEGMENTO);
+    if (ll.error) std::rethrow_exception(ll.error);
+}
+
+template <typename F>
+inline auto asegurar(F&& f) -> decltype(f()) {
+    using R = decltype(f());
+    char marca;
+    if (uintptr_t(&marca) - hilo().limite > MARGEN) return f();
+
+    if constexpr (std::is_void<R>::value) {
+        enSegmento([](void* p) { (*static_cast<std::remove_reference_t<F>*>(p))(); }, &f);
+    } else {
+        struct Estado {
+            std::remove_reference_t<F>* f;
+            R resultado;
+        } estado{&f, R()};
+        enSegmento([](void* p) {
+            Estado* e = static_cast<Estado*>(p);
+            e->resultado = (*e->f)();
+        }, &estado);
+        return estado.resultado;
+    }
+}
+
+}  // namespace pila
+
+#endif // PILA_H
@@ -0,0 +1,166 @@
+#ifndef SCAN_TABLES_H
+#define SCAN_TABLES_H
+
+#include "token.h"
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+// Tablas del scanner generadas en tiempo de compilación: clase de cada byte y un
+// hash perfecto para las palabras reservadas.
+
+namespace scan {
+
+enum CharClass : uint8_t {
+    CC_WS       = 1 << 0,   // ' ' '\n' '\t' '\r'
+    CC_DIGIT    = 1 << 1,
+    CC_ID_START = 1 << 2,   // letra o '_'
+    CC_ID_BODY  = 1 << 3    // letra, dígito, '_' o '.' (para "stdio.h")
+};
+
+struct CharTable {
+    uint8_t cls[256];
+    constexpr CharTable() : cls() {
+        for (int c = 0; c < 256; ++c) {
+            uint8_t m = 0;
+            bool letra = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+            bool digito = c >= '0' && c <= '9';
+            if (c == ' ' || c == '\n' || c == '\t' || c == '\r') m |= CC_WS;
+            if (digito) m |= CC_DIGIT;
+            if (letra || c == '_') m |= CC_ID_START;
+            if (letra || digito || c == '_' || c == '.') m |= CC_ID_BODY;
+            cls[c] = m;
+        }
+    }
+};
+
+inline constexpr CharTable charTable{};
+
+inline bool is(char c, uint8_t clase) {
+    return charTable.cls[static_cast<unsigned char>(c)] & clase;
+}
+
+struct Keyword {
+    std::string_view text;
+    Token::Type type;
+};
+
+inline constexpr Keyword keywords[] = {
+    {"void", Token::VOID},       {"int", Token::INT},         {"long", Token::LONG},
+    {"unsigned", Token::UNSIGNED}, {"unsignedl", Token::UNSIGNEDL},
+    {"main", Token::MAIN},       {"return", Token::RETURN},   {"printf", Token::PRINTF},
+    {"if", Token::IF},           {"else", Token::ELSE},       {"for", Token::FOR},
+    {"while", Token::WHILE},     {"include", Token::INCLUDE}, {"stdio.h", Token::LIBRARY}
+};
+inline constexpr size_t numKeywords = sizeof(keywords) / sizeof(keywords[0]);
+inline constexpr uint32_t kwTableSize = 32;
+
+// h = (len * mult + primero * 7 + último) & (tamaño - 1)
+constexpr uint32_t kwHash(uint32_t mult, size_t len, unsigned char first, unsigned char last) {
+    return (uint32_t(len) * mult + uint32_t(first) * 7u + uint32_t(last)) & (kwTableSize - 1);
+}
+
+constexpr bool kwMultIsPerfect(uint32_t mult) {
+    bool usado[kwTableSize] = {};
+    for (size_t i = 0; i < numKeywords; ++i) {
+        std::string_view w = keywords[i].text;
+        uint32_t h = kwHash(mult, w.size(), w.front(), w.back());
+        if (usado[h]) return false;
+        usado[h] = true;
+    }
+    return true;
+}
+
+constexpr uint32_t findKwMult() {
+    for (uint32_t m = 1; m < 4096; ++m)
+        if (kwMultIsPerfect(m)) return m;
+    return 0;
+}
+
+inline constexpr uint32_t kwMult = findKwMult();
+static_assert(kwMult != 0, "no se encontró hash perfecto para las palabras reservadas");
+
+struct KeywordTable {
+    int8_t slot[kwTableSize];
+    constexpr KeywordTable() : slot() {
+        for (uint32_t i = 0; i < kwTableSize; ++i) slot[i] = -1;
+        for (size_t i = 0; i < numKeywords; ++i) {
+            std::string_view w = keywords[i].text;
+            slot[kwHash(kwMult, w.size(), w.front(), w.back())] = int8_t(i);
+        }
+    }
+};
+
+inline constexpr KeywordTable keywordTable{};
+
+// Devuelve el tipo de la palabra reservada o Token::ID.
+inline Token::Type lookupKeyword(std::string_view word) {
+    if (word.empty()) return Token::ID;
+    int8_t i = keywordTable.slot[kwHash(kwMult, word.size(), word.front(), word.back())];
+    if (i >= 0 && keywords[i].text == word) return keywords[i].type;
+    return Token::ID;
+}
+
+// Avanza sobre espacios en blanco desde pos; devuelve la primera posición que no lo es.
+inline size_t skipWhitespace(const char* p, size_t pos, size_t end) {
+#if defined(__AVX2__)
+    const __m256i sp = _mm256_set1_epi8(' '), nl = _mm256_set1_epi8('\n');
+    const __m256i tb = _mm256_set1_epi8('\t'), cr = _mm256_set1_epi8('\r');
+    while (pos + 32 <= end) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + pos));
+        __m256i ws = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, sp), _mm256_cmpeq_epi8(v, nl)),
+                                     _mm256_or_si256(_mm256_cmpeq_epi8(v, tb), _mm256_cmpeq_epi8(v, cr)));
+        uint32_t no = ~uint32_t(_mm256_movemask_epi8(ws));
+        if (no) return pos + __builtin_ctz(no);
+        pos += 32;
+    }
+#endif
+#if defined(__SSE2__)
+    const __m128i sp16 = _mm_set1_epi8(' '), nl16 = _mm_set1_epi8('\n');
+    const __m128i tb16 = _mm_set1_epi8('\t'), cr16 = _mm_set1_epi8('\r');
+    while (pos + 16 <= end) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + pos));
+        __m128i ws = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, sp16), _mm_cmpeq_epi8(v, nl16)),
+                                  _mm_or_si128(_mm_cmpeq_epi8(v, tb16), _mm_cmpeq_epi8(v, cr16)));
+        uint32_t no = ~uint32_t(_mm_movemask_epi8(ws)) & 0xFFFFu;
+        if (no) return pos + __builtin_ctz(no);
+        pos += 16;
+    }
+#endif
+    while (pos < end && is(p[pos], CC_WS)) ++pos;
+    return pos;
+}
+
+// Avanza sobre el cuerpo de un identificador ([A-Za-z0-9_.]).
+inline size_t skipIdentBody(const char* p, size_t pos, size_t end) {
+#if defined(__SSE2__)
+    // Los bytes >= 0x80 son negativos en la comparación con signo y quedan fuera de rango.
+    const __m128i a1 = _mm_set1_epi8('a' - 1), z1 = _mm_set1_epi8('z' + 1);
+    const __m128i d1 = _mm_set1_epi8('0' - 1), d2 = _mm_set1_epi8('9' + 1);
+    const __m128i low = _mm_set1_epi8(0x20), und = _mm_set1_epi8('_'), dot = _mm_set1_epi8('.');
+    while (pos + 16 <= end) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + pos));
+        __m128i l = _mm_or_si128(v, low);  // mayúsculas -> minúsculas
+        __m128i letra = _mm_and_si128(_mm_cmpgt_epi8(l, a1), _mm_cmplt_epi8(l, z1));
+        __m128i digito = _mm_and_si128(_mm_cmpgt_epi8(v, d1), _mm_cmplt_epi8(v, d2));
+        __m128i otro = _mm_or_si128(_mm_cmpeq_epi8(v, und), _mm_cmpeq_epi8(v, dot));
+        __m128i ok = _mm_or_si128(_mm_or_si128(letra, digito), otro);
+        uint32_t no = ~uint32_t(_mm_movemask_epi8(ok)) & 0xFFFFu;
+        if (no) return pos + __builtin_ctz(no);
+        pos += 16;
+    }
+#endif
+    while (pos < end && is(p[pos], CC_ID_BODY)) ++pos;
+    return pos;
+}
+
+} // namespace scan
+
+#endif // SCAN_TABLES_H
@@ -2,20 +2,35 @@
 #define SCANNER_H
 
 #include "token.h"
+#include "scan_tables.h"
+#include "token_buffer.h"
+#include "traza.h"
+#include "diagnosticos.h"
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <cstring>
 #include <cctype>
 #include<vector>
 #include <iostream>
 
 class Scanner {
+public:
+    // TABLE: tablas constexpr, hash perfecto y SIMD (por defecto).
+    // BASIC: clasificación carácter a carácter; se conserva como referencia para el benchmark.
+    enum Mode { TABLE, BASIC };
+
 private:
+    Mode mode = TABLE;
 
-    std::vector<Token*> token_stream;
-    int token_index = 0;
-    bool use_token_stream = false;
+    std::string_view input;
+    size_t first, current;
+    SymbolTable* simbolos;  // donde se internan los ID (puede ser nulo, p.ej. en el benchmark)
 
-    std::string input;
-    int first, current;
+    // Tokens crudos ya escaneados que esperan ser devueltos (lookahead acotado a 3).
+    Token lookahead[3];
+    int pendientes = 0;
+    int main_count = 0;
 
     bool is_white_space(char c) {
         return c == ' ' || c == '\n' || c == '\t' || c == '\r';
@@ -23,146 +38,239 @@ private:
 
 
 public:
-    Scanner(const char* in_s) : input(in_s), first(0), current(0) {}
+    Scanner(const char* in_s, SymbolTable* tabla = nullptr)
+        : input(in_s, std::strlen(in_s)), first(0), current(0), simbolos(tabla) {}
 
-    Scanner(const std::vector<Token*>& tokens)
-    : token_stream(tokens), token_index(0), use_token_stream(true), first(0), current(0) {}
+    Scanner(std::string_view src, SymbolTable* tabla = nullptr, Mode m = TABLE)
+        : mode(m), input(src), first(0), current(0), simbolos(tabla) {}
 
-    Token* nextToken() {
+    int mainCount() const { return main_count; }
 
-        if (use_token_stream) {
-        if (token_index < token_stream.size())
-            return token_stream[token_index++];
-        else
-            return new Token(Token::END);
+    // Offset en el fuente donde empieza el texto de un token; SIN_POSICION si no apunta
+    // a este fuente. La línea se calcula recién al mostrar el diagnóstico.
+    uint32_t offsetOf(std::string_view texto) const {
+        const char* p = texto.data();
+        if (!p || p < input.data() || p > input.data() + input.size()) return SIN_POSICION;
+        return uint32_t(p - input.data());
+    }
+
+    // Devuelve el siguiente token con los especificadores de tipo ya fusionados:
+    //   unsigned long [int] -> UNSIGNEDL,  unsigned int -> UNSIGNED,
+    //   long int -> LONG,                  int main -> MAIN (cuenta los main).
+    Token nextToken() {
+        Token t = fusionar();
+        TRAZA(SCANNER, DETALLE, t);
+        return t;
+    }
+
+    // Consume el resto del fuente (solo para contar los main que queden).
+    void drain() {
+        while (nextToken().type != Token::END) {}
+    }
+
+private:
+    Token fusionar() {
+        Token t = takeRaw();
+        switch (t.type) {
+            case Token::INT:
+                if (peekRaw(0).type == Token::MAIN) {
+                    main_count++;
+                    return takeRaw();
+                }
+                return t;
+            case Token::UNSIGNED:
+                if (peekRaw(0).type == Token::LONG) {
+                    Token l = takeRaw();
+                    if (peekRaw(0).type == Token::INT)
+                        return merge(Token::UNSIGNEDL, t, takeRaw());
+                    return merge(Token::UNSIGNEDL, t, l);
+                }
+                if (peekRaw(0).type == Token::INT)
+                    return merge(Token::UNSIGNED, t, takeRaw());
+                return t;
+            case Token::LONG:
+                if (peekRaw(0).type == Token::INT)
+                    return merge(Token::LONG, t, takeRaw());
+                return t;
+            default:
+                return t;
         }
+    }
 
-        while (current < input.length() && is_white_space(input[current]))
-            current++;
+    Token peekRaw(int k) {
+        while (pendientes <= k) lookahead[pendientes++] = scanToken();
+        return lookahead[k];
+    }
+
+    Token takeRaw() {
+        if (pendientes == 0) return scanToken();
+        Token t = lookahead[0];
+        for (int i = 1; i < pendientes; ++i) lookahead[i - 1] = lookahead[i];
+        pendientes--;
+        return t;
+    }
 
-        if (current >= input.length()) return new Token(Token::END);
+    Token identifier(std::string_view word) {
+        return Token(Token::ID, word, simbolos ? simbolos->intern(word) : NO_SYMBOL);
+    }
+
+    // El token fusionado abarca el texto desde a hasta el final de b.
+    static Token merge(Token::Type type, const Token& a, const Token& b) {
+        return Token(type, std::string_view(a.text.data(), b.text.data() + b.text.size() - a.text.data()));
+    }
+
+    Token scanToken() {
+        if (mode == TABLE)
+            current = scan::skipWhitespace(input.data(), current, input.length());
+        else
+            while (current < input.length() && is_white_space(input[current]))
+                current++;
+
+        if (current >= input.length()) return Token(Token::END, input.substr(input.length()));
 
         char c = input[current];
         first = current;
 
         if (c == '"') {
             current++;
-            int start = current;
+            size_t start = current;
             while (current < input.length() && input[current] != '"') {
                 if (input[current] == '\\' && current + 1 < input.length()) current += 2;
                 else current++;
             }
-            std::string content = input.substr(start, current - start);
+            std::string_view content = input.substr(start, current - start);
             if (current < input.length() && input[current] == '"') current++;
-            return new Token(Token::STRING, content);
+            return Token(Token::STRING, content);
         }
 
-        if (isdigit(c)) {
-            current++;
-            while (current < input.length() && isdigit(input[current])) current++;
-            return new Token(Token::NUM, input, first, current - 1);
+        if (mode == TABLE) {
+            if (scan::is(c, scan::CC_DIGIT)) {
+                current++;
+                while (current < input.length() && scan::is(input[current], scan::CC_DIGIT)) current++;
+                return Token(Token::NUM, input.substr(first, current - first));
+            }
+            if (scan::is(c, scan::CC_ID_START)) {
+                current = scan::skipIdentBody(input.data(), current + 1, input.length());
+                std::string_view word = input.substr(first, current - first);
+                Token::Type tipo = scan::lookupKeyword(word);
+                if (tipo == Token::ID) return identifier(word);
+                return Token(tipo, word);
+            }
         }
+        else {
+            if (isdigit(c)) {
+                current++;
+                while (current < input.length() && isdigit(input[current])) current++;
+                return Token(Token::NUM, input.substr(first, current - first));
+            }
 
-        if (isalpha(c) || c == '_') {
-            current++;
-            while (current < input.length() && (isalnum(input[current]) || input[current] == '_' || input[current] == '.')) current++;
-            std::string word = input.substr(first, current - first);
-
-            if (word == "void") return new Token(Token::VOID, word);
-            if (word == "int") return new Token(Token::INT, word);
-            if (word == "long") return new Token(Token::LONG, word);
-            if (word == "unsigned") return new Token(Token::UNSIGNED, word);
-            if (word == "unsignedl") return new Token(Token::UNSIGNEDL, word);
-            if (word == "main") return new Token(Token::MAIN, word);
-            if (word == "return") return new Token(Token::RETURN, word);
-            if (word == "printf") return new Token(Token::PRINTF, word);
-            if (word == "if") return new Token(Token::IF, word);
-            if (word == "else") return new Token(Token::ELSE, word);
-            if (word == "for") return new Token(Token::FOR, word);
-            if (word == "while") return new Token(Token::WHILE, word);
-
-            if (word == "include") return new Token(Token::INCLUDE, word);
-            if (word == "stdio.h") return new Token(Token::LIBRARY, word);
-
-            return new Token(Token::ID, word);
+            if (isalpha(c) || c == '_') {
+                current++;
+                while (current < input.length() && (isalnum(input[current]) || input[current] == '_' || input[current] == '.')) current++;
+                std::string_view word = input.substr(first, current - first);
+
+                if (word == "void") return Token(Token::VOID, word);
+                if (word == "int") return Token(Token::INT, word);
+                if (word == "long") return Token(Token::LONG, word);
+                if (word == "unsigned") return Token(Token::UNSIGNED, word);
+                if (word == "unsignedl") return Token(Token::UNSIGNEDL, word);
+                if (word == "main") return Token(Token::MAIN, word);
+                if (word == "return") return Token(Token::RETURN, word);
+                if (word == "printf") return Token(Token::PRINTF, word);
+                if (word == "if") return Token(Token::IF, word);
+                if (word == "else") return Token(Token::ELSE, word);
+                if (word == "for") return Token(Token::FOR, word);
+                if (word == "while") return Token(Token::WHILE, word);
+
+                if (word == "include") return Token(Token::INCLUDE, word);
+                if (word == "stdio.h") return Token(Token::LIBRARY, word);
+
+                return identifier(word);
+            }
         }
 
         switch (c) {
             case '+':
                 if (current + 1 < input.length() && input[current + 1] == '+') {
-                    current += 2; return new Token(Token::INCRE, "++");
+                    current += 2; return Token(Token::INCRE, input.substr(first, 2));
                 }
                 if (current + 1 < input.length() && input[current + 1] == '=') {
-                    current += 2; return new Token(Token::PLUSASSING, "+=");
+                    current += 2; return Token(Token::PLUSASSING, input.substr(first, 2));
                 }
-                current++; return new Token(Token::PLUS, "+");
+                current++; return Token(Token::PLUS, input.substr(first, 1));
 
             case '-':
                 if (current + 1 < input.length() && input[current + 1] == '-') {
-                    current += 2; return new Token(Token::DECRE, "--");
+                    current += 2; return Token(Token::DECRE, input.substr(first, 2));
                 }
                 if (current + 1 < input.length() && input[current + 1] == '=') {
-                    current += 2; return new Token(Token::MINUSASSING, "-=");
+                    current += 2; return Token(Token::MINUSASSING, input.substr(first, 2));
                 }
-                current++; return new Token(Token::MINUS, "-");
+                current++; return Token(Token::MINUS, input.substr(first, 1));
 
-            case '*': current++; return new Token(Token::MULT, "*");
-            case '/': current++; return new Token(Token::DIV, "/");
+            case '*': current++; return Token(Token::MULT, input.substr(first, 1));
+            case '/': current++; return Token(Token::DIV, input.substr(first, 1));
 
             case '=':
                 if (current + 1 < input.length() && input[current + 1] == '=') {
-                    current += 2; return new Token(Token::EQ, "==");
+                    current += 2; return Token(Token::EQ, input.substr(first, 2));
                 }
-                current++; return new Token(Token::ASSING, "=");
+                current++; return Token(Token::ASSING, input.substr(first, 1));
 
             case '<':
                 if (current + 1 < input.length() && input[current + 1] == '=') {
-                    current += 2; return new Token(Token::LR, "<=");
+                    current += 2; return Token(Token::LR, input.substr(first, 2));
                 }
-                current++; return new Token(Token::LT, "<");
+                current++; return Token(Token::LT, input.substr(first, 1));
 
             case '>':
                 if (current + 1 < input.length() && input[current + 1] == '=') {
-                    current += 2; return new Token(Token::GE, ">=");
+                    current += 2; return Token(Token::GE, input.substr(first, 2));
                 }
-                current++; return new Token(Token::GT, ">");
+                current++; return Token(Token::GT, input.substr(first, 1));
 
             case '!':
                 if (current + 1 < input.length() && input[current + 1] == '=') {
-                    current += 2; return new Token(Token::NE, "!=");
+                    current += 2; return Token(Token::NE, input.substr(first, 2));
                 }
-                current++; return new Token(Token::ERR, "!");
+                current++; return Token(Token::ERR, input.substr(first, 1));
             
-            case '(': current++; return new Token(Token::PI, "(");  
-            case ')': current++; return new Token(Token::PD, ")");  
-            case '{': current++; return new Token(Token::CD, "{");
-            case '}': current++; return new Token(Token::CI, "}");
-            case ';': current++; return new Token(Token::PC, ";");
-            case ',': current++; return new Token(Token::COMA, ",");
-            case '#': current++; return new Token(Token::HASH, "#");
+            case '(': current++; return Token(Token::PI, input.substr(first, 1));  
+            case ')': current++; return Token(Token::PD, input.substr(first, 1));  
+            case '{': current++; return Token(Token::CD, input.substr(first, 1));
+            case '}': current++; return Token(Token::CI, input.substr(first, 1));
+            case ';': current++; return Token(Token::PC, input.substr(first, 1));
+            case ',': current++; return Token(Token::COMA, input.substr(first, 1));
+            case '#': current++; return Token(Token::HASH, input.substr(first, 1));
 
             default:
                 current++;
-                return new Token(Token::ERR, std::string(1, c));
+                return Token(Token::ERR, input.substr(first, 1));
         }
     }
-    std::vector<Token*> scanAllTokens() {
-        std::vector<Token*> tokens;
-        Token* t;
-        while ((t = nextToken())->type != Token::END) {
-            tokens.push_back(t);
-        }
+public:
+    // Escanea todo el fuente a un TokenBuffer terminado en END.
+    TokenBuffer scanAll() {
+        if (input.length() > UINT32_MAX)
+            throw std::length_error("el fuente supera los 4 GB que admiten los offsets de token");
+        TokenBuffer tokens(input);
+        tokens.reserve(input.length() / 4 + 1);
+        Token t;
+        do {
+            t = nextToken();
+            tokens.push(t);
+        } while (t.type != Token::END);
         return tokens;
     }
 
 
 };
 
-void test_scanner(Scanner* scanner) {
-    Token* current;
+inline void test_scanner(Scanner* scanner) {
+    Token current;
     std::cout << "Escaneando:\n";
-    while ((current = scanner->nextToken())->type != Token::END) {
-        std::cout << *current << "\n";
+    while ((current = scanner->nextToken()).type != Token::END) {
+        std::cout << current << "\n";
     }
     std::cout << "TOKEN(END)\n";
 }
@@ -0,0 +1,331 @@
+#ifndef SERVIDOR_H
+#define SERVIDOR_H
+
+#include <arpa/inet.h>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <fcntl.h>
+#include <iostream>
+#include <mutex>
+#include <poll.h>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "compilador.h"
+
+// Servidor de compilación: un proceso que queda vivo y compila lo que le mandan, sin
+// archivos intermedios. Cada pedido y cada respuesta llevan prefijo de largo:
+//   pedido:    u32 largo, fuente
+//   respuesta: u32 resultado (Compilador::Resultado), u32 largo, assembly (vacío si no
+//              compiló), u32 largo, diagnósticos en JSON (Diagnosticos::escribirJSON)
+// Los u32 van en orden de red. Por una conexión se pueden mandar varios pedidos
+// seguidos; las respuestas salen en el mismo orden.
+//
+// --servidor=RUTA escucha en un socket Unix. Un hilo hace poll sobre todas las conexiones
+// y junta los bytes de cada pedido; cuando uno está completo lo pasa a un pool fijo de
+// hilos, cada uno con su Compilador, que conserva sus arenas entre pedidos. Así una
+// conexión ocupa un hilo del pool solo mientras se compila un pedido suyo, y las que están
+// abiertas sin mandar nada no demoran a las demás. Mientras un pedido de una conexión está
+// en el pool no se lee el siguiente, para que las respuestas salgan en orden.
+// SIGINT o SIGTERM cierran el socket, terminan los pedidos ya recibidos y borran RUTA.
+// --servidor=- atiende una sola conexión por stdin/stdout.
+
+namespace servidor {
+
+// Un pedido más largo cierra la conexión. Los bytes se guardan a medida que llegan, así
+// que un cliente solo ocupa la memoria que efectivamente mandó.
+constexpr uint32_t LARGO_MAXIMO = 16u << 20;
+// Una respuesta que el cliente no lee en este tiempo cierra la conexión y libera al hilo.
+constexpr int SEGUNDOS_ESCRITURA = 10;
+
+inline bool leerTodo(int fd, char* datos, size_t n) {
+    while (n > 0) {
+        ssize_t r = ::read(fd, datos, n);
+        if (r == 0) return false;
+        if (r < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        datos += r;
+        n -= size_t(r);
+    }
+    return true;
+}
+
+inline bool escribirTodo(int fd, const char* datos, size_t n) {
+    while (n > 0) {
+        ssize_t w = ::write(fd, datos, n);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        datos += w;
+        n -= size_t(w);
+    }
+    return true;
+}
+
+inline void agregarU32(std::string& s, uint32_t v) {
+    v = htonl(v);
+    s.append(reinterpret_cast<const char*>(&v), sizeof(v));
+}
+
+inline uint32_t leerU32(const char* p) {
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return ntohl(v);
+}
+
+// Compila un pedido y deja la respuesta completa en `respuesta`. Si el compilador lanza
+// (p.ej. sin memoria), la respuesta es un ERROR_SINTAXIS con el mensaje de la excepción
+// como único diagnóstico: el cliente siempre recibe una respuesta.
+inline void responder(Compilador& compilador, std::string_view fuente, std::string& assembly,
+                      std::string& respuesta) {
+    Compilador::Resultado resultado;
+    std::ostringstream diagnosticos;
+    try {
+        resultado = compilador.compilar(fuente, assembly);
+        compilador.diagnosticos().escribirJSON(diagnosticos, fuente);
+    } catch (const std::exception& e) {
+        std::cerr << "servidor: " << e.what() << std::endl;
+        resultado = Compilador::ERROR_SINTAXIS;
+        assembly.clear();
+        Diagnosticos fallo;
+        fallo.agregar(SEV_ERROR, DIAG_SINTAXIS, SIN_POSICION, "", std::string("error interno: ") + e.what());
+        diagnosticos.str("");
+        fallo.escribirJSON(diagnosticos, fuente);
+    }
+    std::string json = diagnosticos.str();
+
+    respuesta.clear();
+    agregarU32(respuesta, uint32_t(resultado));
+    agregarU32(respuesta, uint32_t(assembly.size()));
+    respuesta += assembly;
+    agregarU32(respuesta, uint32_t(json.size()));
+    respuesta += json;
+}
+
+// Atiende pedidos de `entrada` y responde por `salida` hasta que el cliente cierra.
+inline void atender(Compilador& compilador, int entrada, int salida) {
+    std::string fuente, assembly, respuesta;
+    char largo[4];
+    while (leerTodo(entrada, largo, sizeof(largo))) {
+        uint32_t n = leerU32(largo);
+        if (n > LARGO_MAXIMO) return;
+        fuente.resize(n);
+        if (!leerTodo(entrada, &fuente[0], n)) return;
+        responder(compilador, fuente, assembly, respuesta);
+        if (!escribirTodo(salida, respuesta.data(), respuesta.size())) return;
+    }
+}
+
+inline int porEntradaEstandar() {
+    std::signal(SIGPIPE, SIG_IGN);
+    Compilador compilador;
+    atender(compilador, STDIN_FILENO, STDOUT_FILENO);
+    return 0;
+}
+
+inline int porSocket(const std::string& ruta, unsigned hilos) {
+    sockaddr_un direccion{};
+    direccion.sun_family = AF_UNIX;
+    if (ruta.size() >= sizeof(direccion.sun_path)) {
+        std::cerr << "Ruta de socket demasiado larga: " << ruta << std::endl;
+        return 1;
+    }
+    std::memcpy(direccion.sun_path, ruta.c_str(), ruta.size() + 1);
+
+    // Un socket que quedó de una corrida anterior se reemplaza; cualquier otro archivo, no.
+    struct stat st;
+    if (lstat(ruta.c_str(), &st) == 0 && S_ISSOCK(st.st_mode)) ::unlink(ruta.c_str());
+    int escucha = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (escucha < 0 || ::bind(escucha, reinterpret_cast<sockaddr*>(&direccion), sizeof(direccion)) != 0 ||
+        ::listen(escucha, SOMAXCONN) != 0) {
+        std::cerr << "No se pudo escuchar en " << ruta << ": " << std::strerror(errno) << std::endl;
+        if (escucha >= 0) ::close(escucha);
+        return 1;
+    }
+    // Los hilos del pool y el de señales despiertan al poll escribiendo un byte aquí.
+    int despertar[2];
+    if (pipe2(despertar, O_NONBLOCK | O_CLOEXEC) != 0) {
+        std::cerr << "servidor: " << std::strerror(errno) << std::endl;
+        ::close(escucha);
+        return 1;
+    }
+    auto avisar = [&] {
+        char c = 0;
+        ssize_t r = ::write(despertar[1], &c, 1);  // si el pipe está lleno, ya hay aviso pendiente
+        (void)r;
+    };
+
+    // Las señales las recibe solo hiloSenales (con sigwait).
+    sigset_t senales;
+    sigemptyset(&senales);
+    sigaddset(&senales, SIGINT);
+    sigaddset(&senales, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &senales, nullptr);
+    std::signal(SIGPIPE, SIG_IGN);
+    std::atomic<bool> terminar{false};
+    std::thread hiloSenales([&] {
+        int s;
+        sigwait(&senales, &s);
+        terminar = true;
+        avisar();
+    });
+
+    struct Pedido {
+        int cliente;
+        std::string fuente;
+    };
+    struct Devuelta {
+        int cliente;
+        bool viva;  // false: la respuesta no se pudo escribir y hay que cerrarla
+    };
+    std::mutex mutex;
+    std::condition_variable hayPedido;
+    std::deque<Pedido> cola;
+    std::vector<Devuelta> devueltas;
+    bool cerrando = false;
+
+    std::vector<std::thread> pool;
+    for (unsigned h = 0; h < hilos; ++h) {
+        pool.emplace_back([&] {
+            Compilador compilador;
+            std::string assembly, respuesta;
+            while (true) {
+                Pedido p;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    hayPedido.wait(lock, [&] { return cerrando || !cola.empty(); });
+                    if (cola.empty()) return;
+                    p = std::move(cola.front());
+                    cola.pop_front();
+                }
+                responder(compilador, p.fuente, assembly, respuesta);
+                bool viva = escribirTodo(p.cliente, respuesta.data(), respuesta.size());
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    devueltas.push_back({p.cliente, viva});
+                }
+                avisar();
+            }
+        });
+    }
+    std::cerr << "Servidor de compilación en " << ruta << " (" << hilos << " hilos)" << std::endl;
+
+    // Lo que se lleva leído de cada conexión. Solo este hilo abre y cierra conexiones, así
+    // que un descriptor no se reusa mientras un pedido suyo está en el pool.
+    struct Conexion {
+        std::string datos;     // prefijo de largo y fuente del pedido en curso (y lo que siga)
+        bool enPool = false;
+    };
+    std::unordered_map<int, Conexion> conexiones;
+    auto cerrar = [&](int cliente) {
+        conexiones.erase(cliente);
+        ::close(cliente);
+    };
+    // Si `datos` ya tiene un pedido completo, lo manda al pool. false si el largo no se admite.
+    auto despachar = [&](int cliente, Conexion& c) {
+        if (c.datos.size() < 4) return true;
+        uint32_t largo = leerU32(c.datos.data());
+        if (largo > LARGO_MAXIMO) return false;
+        if (c.datos.size() < 4 + size_t(largo)) return true;
+        Pedido p{cliente, c.datos.substr(4, largo)};
+        c.datos.erase(0, 4 + size_t(largo));
+        c.enPool = true;
+        std::lock_guard<std::mutex> lock(mutex);
+        cola.push_back(std::move(p));
+        hayPedido.notify_one();
+        return true;
+    };
+
+    std::vector<pollfd> fds;
+    std::vector<Devuelta> listas;
+    char buffer[64 * 1024];
+    while (!terminar) {
+        fds.clear();
+        fds.push_back({despertar[0], POLLIN, 0});
+        fds.push_back({escucha, POLLIN, 0});
+        for (auto& [cliente, c] : conexiones)
+            if (!c.enPool) fds.push_back({cliente, POLLIN, 0});
+        if (::poll(fds.data(), fds.size(), -1) < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "servidor: " << std::strerror(errno) << std::endl;
+            break;
+        }
+
+        if (fds[0].revents) {
+            while (::read(despertar[0], buffer, sizeof(buffer)) > 0) {}
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                listas.swap(devueltas);
+            }
+            for (const Devuelta& d : listas) {
+                Conexion& c = conexiones[d.cliente];
+                c.enPool = false;
+                // Lo que el cliente mandó detrás del pedido puede ser ya el siguiente.
+                if (!d.viva || !despachar(d.cliente, c)) cerrar(d.cliente);
+            }
+            listas.clear();
+        }
+
+        if (fds[1].revents) {
+            int cliente = ::accept4(escucha, nullptr, nullptr, SOCK_CLOEXEC);
+            if (cliente >= 0) {
+                timeval limite{SEGUNDOS_ESCRITURA, 0};
+                setsockopt(cliente, SOL_SOCKET, SO_SNDTIMEO, &limite, sizeof(limite));
+                conexiones.emplace(cliente, Conexion());
+            }
+        }
+
+        for (size_t i = 2; i < fds.size(); ++i) {
+            if (!fds[i].revents) continue;
+            int cliente = fds[i].fd;
+            Conexion& c = conexiones[cliente];
+            ssize_t r = ::recv(cliente, buffer, sizeof(buffer), MSG_DONTWAIT);
+            if (r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) continue;
+            if (r <= 0) {
+                cerrar(cliente);
+                continue;
+            }
+            c.datos.append(buffer, size_t(r));
+            if (!despachar(cliente, c)) cerrar(cliente);
+        }
+    }
+
+    // Los pedidos ya recibidos se compilan y se responden; después se cierra todo.
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        cerrando = true;
+    }
+    hayPedido.notify_all();
+    for (std::thread& t : pool) t.join();
+    for (auto& conexion : conexiones) ::close(conexion.first);
+    pthread_kill(hiloSenales.native_handle(), SIGTERM);
+    hiloSenales.join();
+    ::close(escucha);
+    ::close(despertar[0]);
+    ::close(despertar[1]);
+    ::unlink(ruta.c_str());
+    return 0;
+}
+
+}  // namespace servidor
+
+#endif // SERVIDOR_H
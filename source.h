@@ -0,0 +1,107 @@
+#ifndef SOURCE_H
+#define SOURCE_H
+
+#include <string>
+#include <string_view>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Código fuente de entrada. Los archivos regulares se mapean con mmap (una sola
+// copia, la del page cache); stdin, pipes y archivos que no se pueden mapear se
+// leen por bloques a un único buffer. Los tokens apuntan directamente a estos bytes,
+// así que el SourceBuffer debe vivir hasta terminar la compilación.
+class SourceBuffer {
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    bool mapped_ = false;
+    size_t liberado_ = 0;  // liberarHasta ya devolvió [0, liberado_)
+    std::string owned_;
+
+    void release() {
+        if (mapped_) munmap(const_cast<char*>(data_), size_);
+        data_ = nullptr;
+        size_ = 0;
+        mapped_ = false;
+        liberado_ = 0;
+        owned_.clear();
+    }
+
+    bool readStream(int fd, std::string& err) {
+        char chunk[1 << 16];
+        while (true) {
+            ssize_t n = ::read(fd, chunk, sizeof(chunk));
+            if (n == 0) break;
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                err = std::strerror(errno);
+                return false;
+            }
+            owned_.append(chunk, n);
+        }
+        data_ = owned_.data();
+        size_ = owned_.size();
+        return true;
+    }
+
+public:
+    SourceBuffer() {}
+    SourceBuffer(const SourceBuffer&) = delete;
+    SourceBuffer& operator=(const SourceBuffer&) = delete;
+    ~SourceBuffer() { release(); }
+
+    // path == "-" lee de stdin.
+    bool open(const std::string& path, std::string& err) {
+        release();
+        if (path == "-") return readStream(STDIN_FILENO, err);
+
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            err = std::strerror(errno);
+            return false;
+        }
+        struct stat st;
+        bool ok;
+        if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+            void* p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) {
+                madvise(p, st.st_size, MADV_SEQUENTIAL);
+                data_ = static_cast<const char*>(p);
+                size_ = st.st_size;
+                mapped_ = true;
+                ok = true;
+            } else {
+                ok = readStream(fd, err);
+            }
+        } else {
+            ok = readStream(fd, err);
+        }
+        ::close(fd);
+        return ok;
+    }
+
+    const char* data() const { return data_ ? data_ : ""; }
+    size_t size() const { return size_; }
+    std::string_view view() const { return std::string_view(data(), size_); }
+
+    // Modo flujo: devuelve al sistema las páginas mapeadas que quedan enteras antes de
+    // `hasta`, que ya se leyeron. Siguen siendo válidas: si algo vuelve a leerlas, se
+    // releen del archivo. Un `hasta` menor que el anterior es otra pasada que empezó
+    // desde el principio. Sin efecto si el fuente no está mapeado.
+    void liberarHasta(size_t hasta) {
+        if (!mapped_) return;
+        size_t pagina = size_t(sysconf(_SC_PAGESIZE));
+        hasta = (hasta < size_ ? hasta : size_) / pagina * pagina;
+        if (hasta < liberado_) liberado_ = 0;
+        if (hasta > liberado_) {
+            madvise(const_cast<char*>(data_) + liberado_, hasta - liberado_, MADV_DONTNEED);
+            liberado_ = hasta;
+        }
+    }
+};
+
+#endif // SOURCE_H
@@ -0,0 +1,78 @@
+#ifndef SYMBOLS_H
+#define SYMBOLS_H
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Identificador internado: índice denso en la SymbolTable de la compilación.
+using Symbol = uint32_t;
+constexpr Symbol NO_SYMBOL = UINT32_MAX;
+
+// Tabla de identificadores. El scanner interna cada ID una sola vez; las fases
+// siguientes trabajan con el Symbol (comparar es comparar enteros, y los mapas
+// por variable o función pasan a ser arreglos indexados por Symbol).
+class SymbolTable {
+private:
+    static constexpr size_t BLOQUE = 16 * 1024;
+
+    std::unordered_map<std::string_view, Symbol> indice;
+    std::vector<std::string_view> nombres;
+    std::vector<std::unique_ptr<char[]>> bloques;  // copia propia de los textos
+    char* cursor = nullptr;
+    size_t libre = 0;
+
+    std::string_view guardar(std::string_view s) {
+        if (libre < s.size()) {
+            size_t tam = s.size() > BLOQUE ? s.size() : BLOQUE;
+            bloques.emplace_back(new char[tam]);
+            cursor = bloques.back().get();
+            libre = tam;
+        }
+        char* destino = cursor;
+        std::memcpy(destino, s.data(), s.size());
+        cursor += s.size();
+        libre -= s.size();
+        return std::string_view(destino, s.size());
+    }
+
+public:
+    SymbolTable() {}
+    SymbolTable(const SymbolTable&) = delete;
+    SymbolTable& operator=(const SymbolTable&) = delete;
+
+    Symbol intern(std::string_view nombre) {
+        auto it = indice.find(nombre);
+        if (it != indice.end()) return it->second;
+        std::string_view propio = guardar(nombre);
+        Symbol id = Symbol(nombres.size());
+        nombres.push_back(propio);
+        indice.emplace(propio, id);
+        return id;
+    }
+
+    // NO_SYMBOL si el nombre nunca apareció.
+    Symbol find(std::string_view nombre) const {
+        auto it = indice.find(nombre);
+        return it == indice.end() ? NO_SYMBOL : it->second;
+    }
+
+    std::string_view name(Symbol s) const {
+        return s == NO_SYMBOL ? std::string_view() : nombres[s];
+    }
+
+    size_t size() const { return nombres.size(); }
+
+    void clear() {
+        indice.clear();
+        nombres.clear();
+        bloques.clear();
+        cursor = nullptr;
+        libre = 0;
+    }
+};
+
+#endif // SYMBOLS_H
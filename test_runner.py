@@ -1,4 +1,4 @@
-import subprocess, glob, shutil, os
+import subprocess, glob, shutil, os, tempfile
 
 # 1) Patrón de inputs
 pattern = "inputs/input*.txt"
@@ -7,7 +7,7 @@ print("→ Buscando tests con:", pattern)
 print("→ Encontrados   :", INPUTS)
 
 # 2) Nombres de archivos temporales
-WORK_S   = "output.s"
+OUT_DIR  = "salida_tests"   # aquí deja el compilador un .s por test (modo --lote)
 WORK_EXE = "temp_exec"
 STD_EXE  = "temp_std"
 
@@ -21,29 +21,53 @@ def run_std(inp_path):
     os.remove(STD_EXE)
     return "".join(p.stdout.split())
 
-def run_mine(inp_path):
-    # 1) Copia test a input.txt
-    shutil.copy(inp_path, "input.txt")
-
-    # 1.5) Elimina output.s de corridas anteriores
-    if os.path.exists(WORK_S):
-        os.remove(WORK_S)
-
-    # 2) Ejecuta tu compilador (silenciando stdout/stderr)
+def compile_all(inputs):
+    # Compila todos los tests en una sola corrida del compilador
+    if os.path.exists(OUT_DIR):
+        shutil.rmtree(OUT_DIR)
     subprocess.run(
-        ["./programa"],
+        ["./programa", f"--lote={OUT_DIR}", *inputs],
         stdout=subprocess.DEVNULL,
-        stderr=subprocess.DEVNULL,
-        check=True
+        stderr=subprocess.DEVNULL
     )
 
-    # 3) Ensambla+linkea con GCC
+def check_enlace():
+    # compilador.h se usa como biblioteca: dos .cpp que lo incluyen tienen que enlazar
+    # juntos (una función no inline en un header daría "multiple definition")
+    with tempfile.TemporaryDirectory() as tmp:
+        a = os.path.join(tmp, "a.cpp")
+        b = os.path.join(tmp, "b.cpp")
+        with open(a, "w") as f:
+            f.write('#include "compilador.h"\n'
+                    'int compilarUno() { Compilador c; std::string s; return c.compilar(std::string_view(""), s); }\n')
+        with open(b, "w") as f:
+            f.write('#include "compilador.h"\n#include "lote.h"\n#include "servidor.h"\n'
+                    'int compilarUno();\nint main() { return compilarUno() == Compilador::ERROR_SINTAXIS ? 0 : 1; }\n')
+        exe = os.path.join(tmp, "enlace")
+        p = subprocess.run(["g++", "-std=c++17", "-I.", a, b, "visitor.cpp", "-o", exe, "-pthread"],
+                           stderr=subprocess.PIPE, text=True)
+        if p.returncode != 0:
+            print("compilador.h en dos unidades: ❌")
+            print(p.stderr)
+            return False
+        ok = subprocess.run([exe]).returncode == 0
+        print(f"compilador.h en dos unidades: {'✅' if ok else '❌'}")
+        return ok
+
+def run_mine(inp_path):
+    # 1) El .s que dejó compile_all (no existe si el test no compiló)
+    name = os.path.splitext(os.path.basename(inp_path))[0]
+    s_path = os.path.join(OUT_DIR, name + ".s")
+    if not os.path.exists(s_path):
+        raise subprocess.CalledProcessError(1, "./programa")
+
+    # 2) Ensambla+linkea con GCC
     subprocess.run(
-        ["gcc", "-no-pie", WORK_S, "-o", WORK_EXE],
+        ["gcc", "-no-pie", s_path, "-o", WORK_EXE],
         check=True
     )
 
-    # 4) Ejecuta y captura
+    # 3) Ejecuta y captura
     p = subprocess.run([f"./{WORK_EXE}"], stdout=subprocess.PIPE, text=True)
     os.remove(WORK_EXE)
     return "".join(p.stdout.split())
@@ -53,6 +77,8 @@ if __name__ == "__main__":
         print("❌ No se encontraron archivos de test en inputs/")
         exit(1)
 
+    check_enlace()
+    compile_all(INPUTS)
     for inp in INPUTS:
         name = os.path.basename(inp)
 
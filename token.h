@@ -3,22 +3,23 @@
 
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <cctype>
+#include <cstdint>
+#include "symbols.h"
 
 class Token {
 public:
-    enum Type {HASH, INCLUDE, LIBRARY, VOID, UNSIGNED, UNSIGNEDL, INT, LONG, IF, ELSE, WHILE, FOR, RETURN, PRINTF, MAIN, PLUS, MINUS, MULT, DIV,
+    enum Type : uint8_t {HASH, INCLUDE, LIBRARY, VOID, UNSIGNED, UNSIGNEDL, INT, LONG, IF, ELSE, WHILE, FOR, RETURN, PRINTF, MAIN, PLUS, MINUS, MULT, DIV,
                INCRE, DECRE, ASSING, PLUSASSING, MINUSASSING, LT, LR, EQ, GT, GE, NE, PD, PI, CD, CI, PC, COMA, ID, NUM, STRING, ERR, END };
 
     Type type;
-    std::string text;
-
-    Token(Type type) : type(type), text("") {}
-    Token(Type type, char c) : type(type), text(std::string(1, c)) {}
-    Token(Type type, const std::string& source, int first, int last)
-        : type(type), text(source.substr(first, last - first + 1)) {}
-    Token(Type type, const std::string& value)
-        : type(type), text(value) {}
+    std::string_view text;  // apunta al fuente (o a un literal estático), no se copia
+    Symbol sym;             // identificador internado (solo tokens ID)
+
+    Token(Type type = END) : type(type), text(), sym(NO_SYMBOL) {}
+    Token(Type type, std::string_view value, Symbol s = NO_SYMBOL)
+        : type(type), text(value), sym(s) {}
 
     static std::string tokenTypeToString(Type type) {
         switch (type) {
@@ -0,0 +1,55 @@
+#ifndef TOKEN_BUFFER_H
+#define TOKEN_BUFFER_H
+
+#include "token.h"
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// Secuencia de tokens en arreglos paralelos (tipo de 8 bits, offset y largo de 32 bits
+// dentro del fuente y el Symbol de los ID): 13 bytes por token y ninguna reserva de
+// memoria por token.
+// Siempre termina en un token END, así que el parser puede indexar sin chequear límites.
+class TokenBuffer {
+private:
+    std::string_view source;
+    std::vector<Token::Type> types;
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> lengths;
+    std::vector<Symbol> syms;
+
+public:
+    explicit TokenBuffer(std::string_view src = {}) : source(src) {}
+
+    void reserve(size_t n) {
+        types.reserve(n);
+        offsets.reserve(n);
+        lengths.reserve(n);
+        syms.reserve(n);
+    }
+
+    void push(Token::Type t, uint32_t offset, uint32_t length, Symbol sym = NO_SYMBOL) {
+        types.push_back(t);
+        offsets.push_back(offset);
+        lengths.push_back(length);
+        syms.push_back(sym);
+    }
+
+    void push(const Token& t) {
+        push(t.type, uint32_t(t.text.data() - source.data()), uint32_t(t.text.size()), t.sym);
+    }
+
+    size_t size() const { return types.size(); }
+    std::string_view src() const { return source; }
+
+    Token::Type type(size_t i) const { return types[i]; }
+    uint32_t offset(size_t i) const { return offsets[i]; }
+    uint32_t length(size_t i) const { return lengths[i]; }
+    uint32_t end(size_t i) const { return offsets[i] + lengths[i]; }
+    std::string_view text(size_t i) const { return source.substr(offsets[i], lengths[i]); }
+    Symbol sym(size_t i) const { return syms[i]; }
+
+    Token operator[](size_t i) const { return Token(types[i], text(i), syms[i]); }
+};
+
+#endif // TOKEN_BUFFER_H
@@ -0,0 +1,114 @@
+#ifndef TRAZA_H
+#define TRAZA_H
+
+#include <atomic>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+// Trazas de depuración por categoría (scanner, parser, chequeo, codegen) y nivel.
+//
+// En compilación, TRAZA_NIVEL_MAXIMO (por defecto 1: solo INFO) y TRAZA_CATEGORIAS
+// (máscara, por defecto todas) deciden qué trazas existen. Las demás quedan en una
+// rama `if constexpr` descartada y no generan código: con -DTRAZA_NIVEL_MAXIMO=0 no
+// queda ninguna, y con -DTRAZA_NIVEL_MAXIMO=2 se compilan también las de cada token.
+//
+// En ejecución están todas apagadas hasta que main las enciende con --traza=...
+// Cada traza se escribe como una línea completa en stderr, aunque escriban varios hilos.
+
+#ifndef TRAZA_NIVEL_MAXIMO
+#define TRAZA_NIVEL_MAXIMO 1
+#endif
+#ifndef TRAZA_CATEGORIAS
+#define TRAZA_CATEGORIAS 15
+#endif
+
+namespace traza {
+
+enum Categoria : unsigned { SCANNER = 1, PARSER = 2, CHEQUEO = 4, CODEGEN = 8, TODAS = 15 };
+enum Nivel : int { INFO = 1, DETALLE = 2 };
+
+constexpr bool compilada(unsigned categoria, int nivel) {
+    return (TRAZA_CATEGORIAS & categoria) != 0 && nivel <= TRAZA_NIVEL_MAXIMO;
+}
+
+inline std::atomic<unsigned> activas{0};
+inline std::atomic<int> nivelActivo{0};
+inline std::mutex mutexSalida;
+
+inline bool activa(unsigned categoria, int nivel) {
+    return (activas.load(std::memory_order_relaxed) & categoria) != 0 &&
+           nivel <= nivelActivo.load(std::memory_order_relaxed);
+}
+
+inline const char* nombre(unsigned categoria) {
+    switch (categoria) {
+        case SCANNER: return "scanner";
+        case PARSER:  return "parser";
+        case CHEQUEO: return "chequeo";
+        case CODEGEN: return "codegen";
+        default:      return "?";
+    }
+}
+
+// Enciende las trazas pedidas con "categoría,categoría[:nivel]", p.ej. "parser,chequeo"
+// o "todo:2". El nivel por defecto es INFO. Devuelve false si algo no se reconoce.
+inline bool configurar(std::string_view spec) {
+    int nivel = INFO;
+    size_t dosPuntos = spec.find(':');
+    if (dosPuntos != std::string_view::npos) {
+        std::string_view n = spec.substr(dosPuntos + 1);
+        if (n != "1" && n != "2") return false;
+        nivel = n[0] - '0';
+        spec = spec.substr(0, dosPuntos);
+    }
+    unsigned mascara = 0;
+    while (!spec.empty()) {
+        size_t coma = spec.find(',');
+        std::string_view c = spec.substr(0, coma);
+        if (c == "todo") mascara |= TODAS;
+        else if (c == "scanner") mascara |= SCANNER;
+        else if (c == "parser") mascara |= PARSER;
+        else if (c == "chequeo") mascara |= CHEQUEO;
+        else if (c == "codegen") mascara |= CODEGEN;
+        else return false;
+        spec = coma == std::string_view::npos ? std::string_view() : spec.substr(coma + 1);
+    }
+    activas.store(mascara, std::memory_order_relaxed);
+    nivelActivo.store(nivel, std::memory_order_relaxed);
+    return true;
+}
+
+// Arma una línea y la escribe entera al destruirse (al final de la sentencia TRAZA).
+class Linea {
+    std::ostringstream texto;
+
+public:
+    explicit Linea(unsigned categoria) { texto << '[' << nombre(categoria) << "] "; }
+    ~Linea() {
+        texto << '\n';
+        std::lock_guard<std::mutex> lock(mutexSalida);
+        std::clog << texto.str();
+    }
+
+    template <typename T>
+    Linea& operator<<(const T& valor) {
+        texto << valor;
+        return *this;
+    }
+};
+
+}  // namespace traza
+
+// TRAZA(PARSER, DETALLE, "token " << current) : mensaje es una cadena de <<.
+#define TRAZA(categoria, nivel, mensaje)                                                  \
+    do {                                                                                  \
+        if constexpr (traza::compilada(traza::categoria, traza::nivel)) {                 \
+            if (traza::activa(traza::categoria, traza::nivel))                            \
+                traza::Linea(traza::categoria) << mensaje;                                \
+        }                                                                                 \
+    } while (0)
+
+#endif // TRAZA_H
@@ -0,0 +1,97 @@
+#ifndef TYPES_H
+#define TYPES_H
+
+#include <cstdint>
+#include <string>
+
+// Tipo de una expresión o variable en un byte: bit 0 = sin signo, bits 1-2 = ancho
+// (1 = 32 bits, 2 = 64 bits). VOID usa un ancho que no es entero y 0 significa
+// "sin tipo" (una variable que el codegen no conoce).
+enum Tipo : uint8_t {
+    TIPO_NINGUNO   = 0,
+    TIPO_INT       = 1 << 1,
+    TIPO_UNSIGNED  = (1 << 1) | 1,
+    TIPO_LONG      = 2 << 1,
+    TIPO_UNSIGNEDL = (2 << 1) | 1,
+    TIPO_VOID      = 3 << 1
+};
+
+constexpr int NUM_TIPOS = 8;
+
+constexpr bool esEntero(Tipo t) { return t >= TIPO_INT && t <= TIPO_UNSIGNEDL; }
+constexpr bool esSinSigno(Tipo t) { return esEntero(t) && (t & 1); }
+constexpr int bitsDe(Tipo t) { return esEntero(t) ? 16 << (t >> 1) : 0; }
+
+// Nombre en C, tal como aparece en los mensajes y en los comentarios del assembly.
+constexpr const char* nombresTipo[NUM_TIPOS] = {
+    "", "", "int", "unsigned", "long", "unsigned long", "void", ""
+};
+inline std::string nombreTipo(Tipo t) { return nombresTipo[t & (NUM_TIPOS - 1)]; }
+
+// Instrucción que necesita emit_convert para pasar un registro de un tipo a otro.
+enum Conversion : uint8_t {
+    CONV_NINGUNA,
+    CONV_EXTENDER_SIGNO,  // movslq
+    CONV_CEROS_32         // movl reg32, reg32 (limpia la mitad alta)
+};
+
+struct TablasTipo {
+    Tipo promocion[NUM_TIPOS][NUM_TIPOS];   // tipo del resultado de a op b en el chequeador
+    Tipo dominante[NUM_TIPOS][NUM_TIPOS];   // tipo con el que opera el codegen
+    bool truncamiento[NUM_TIPOS][NUM_TIPOS]; // [desde][hacia] pierde los 32 bits altos
+    Conversion conversion[NUM_TIPOS][NUM_TIPOS];
+
+    constexpr TablasTipo() : promocion(), dominante(), truncamiento(), conversion() {
+        for (int i = 0; i < NUM_TIPOS; ++i) {
+            for (int j = 0; j < NUM_TIPOS; ++j) {
+                Tipo a = Tipo(i), b = Tipo(j);
+                // Promoción: el ancho mayor, sin signo si alguno lo es.
+                if (a == b) promocion[i][j] = a;
+                else if (esEntero(a) && esEntero(b)) {
+                    int ancho = (a >> 1) > (b >> 1) ? (a >> 1) : (b >> 1);
+                    promocion[i][j] = Tipo((ancho << 1) | ((a | b) & 1));
+                } else promocion[i][j] = TIPO_INT;
+
+                // Dominante: unsigned long > long > unsigned > int.
+                if (a == TIPO_UNSIGNEDL || b == TIPO_UNSIGNEDL) dominante[i][j] = TIPO_UNSIGNEDL;
+                else if (a == TIPO_LONG || b == TIPO_LONG) dominante[i][j] = TIPO_LONG;
+                else if (a == TIPO_UNSIGNED || b == TIPO_UNSIGNED) dominante[i][j] = TIPO_UNSIGNED;
+                else dominante[i][j] = TIPO_INT;
+
+                truncamiento[i][j] = bitsDe(a) == 64 && bitsDe(b) == 32;
+
+                if (a == TIPO_INT && b == TIPO_LONG) conversion[i][j] = CONV_EXTENDER_SIGNO;
+                else if ((a == TIPO_UNSIGNED && bitsDe(b) == 64) ||
+                         (truncamiento[i][j] && (a & 1) == (b & 1)))
+                    conversion[i][j] = CONV_CEROS_32;
+                else conversion[i][j] = CONV_NINGUNA;
+            }
+        }
+    }
+};
+
+inline constexpr TablasTipo tablasTipo{};
+static_assert(tablasTipo.promocion[TIPO_INT][TIPO_UNSIGNED] == TIPO_UNSIGNED, "promoción int/unsigned");
+static_assert(tablasTipo.promocion[TIPO_LONG][TIPO_UNSIGNED] == TIPO_UNSIGNEDL, "promoción long/unsigned");
+static_assert(tablasTipo.dominante[TIPO_LONG][TIPO_UNSIGNED] == TIPO_LONG, "dominante long/unsigned");
+static_assert(tablasTipo.conversion[TIPO_UNSIGNEDL][TIPO_INT] == CONV_NINGUNA, "conversión unsigned long/int");
+
+inline Tipo promote(Tipo a, Tipo b) { return tablasTipo.promocion[a & 7][b & 7]; }
+inline Tipo getDominantType(Tipo a, Tipo b) { return tablasTipo.dominante[a & 7][b & 7]; }
+inline bool esTruncamientoPorTamanio(Tipo from, Tipo to) { return tablasTipo.truncamiento[from & 7][to & 7]; }
+inline Conversion conversionEntre(Tipo from, Tipo to) { return tablasTipo.conversion[from & 7][to & 7]; }
+
+// Especificadores de printf que acepta el compilador, con su texto y el tipo que esperan.
+enum FormatoPrintf : uint8_t { FORMATO_D, FORMATO_U, FORMATO_LD, FORMATO_LU, NUM_FORMATOS };
+constexpr const char* textoFormato[] = {"d", "u", "ld", "lu"};
+constexpr Tipo tipoFormato[] = {TIPO_INT, TIPO_UNSIGNED, TIPO_LONG, TIPO_UNSIGNEDL};
+static_assert(sizeof(textoFormato) / sizeof(textoFormato[0]) == NUM_FORMATOS, "un texto por formato");
+static_assert(sizeof(tipoFormato) / sizeof(tipoFormato[0]) == NUM_FORMATOS, "un tipo por formato");
+
+inline FormatoPrintf formatoPrintf(const std::string& spec) {
+    for (int f = 0; f < NUM_FORMATOS; ++f)
+        if (spec == textoFormato[f]) return FormatoPrintf(f);
+    return NUM_FORMATOS;
+}
+
+#endif // TYPES_H
@@ -5,6 +5,8 @@
 #include <algorithm>
 #include <climits> 
 #include "visitor.h"
+#include "traza.h"
+#include "paralelo.h"
 
 TypeInfo UnaryExp::accept(Visitor* visitor) { return visitor->visit(this); }
 TypeInfo BinaryExp::accept(Visitor* visitor) { return visitor->visit(this); }
@@ -22,53 +24,23 @@ int Body::accept(Visitor* visitor) { visitor->visit(this); return 0; }
 int FunDec::accept(Visitor* visitor) { visitor->visit(this); return 0; }
 int Program::accept(Visitor* visitor) { visitor->visit(this); return 0; }
 
-bool esTruncamientoPorTamanio(const std::string& from, const std::string& to) {
-    if ((from == "long" && to == "int") ||
-        (from == "unsigned long" && (to == "int" || to == "unsigned")) ||
-        (from == "long" && to == "unsigned"))
-        return true;
-    return false;
-}
-
-std::string promote(std::string a, std::string b) {
-    if (a == b) return a;
-    if ((a == "int" && b == "long") || (a == "long" && b == "int")) return "long";
-    if ((a == "int" && b == "unsigned") || (a == "unsigned" && b == "int")) return "unsigned";
-    if ((a == "long" && b == "unsigned") || (a == "unsigned" && b == "long") ||
-        (a == "int" && b == "unsigned long") || (a == "long" && b == "unsigned long") ||
-        (a == "unsigned long" && b == "int") || (a == "unsigned long" && b == "long")) return "unsigned long";
-    if ((a == "unsigned" && b == "unsigned long") || (a == "unsigned long" && b == "unsigned")) return "unsignedl";
-    return "int";
-}
-
 int que_es(const std::string& s) {
     if (s.find("(%rbp)") != std::string::npos) return 2;
     if (!s.empty() && std::all_of(s.begin(), s.end(), [](char c){ return std::isdigit(c) || c == '-'; })) return 1;
     return 0;
 }
 
-std::string getDominantType(const std::string& a, const std::string& b) {
-    if (a == "unsigned long" || b == "unsigned long") return "unsigned long";
-    if (a == "long" || b == "long") return "long";
-    if (a == "unsigned" || b == "unsigned") return "unsigned";
-    return "int";
-}
-
-bool Visitor::esTruncamientoPeligroso(const TypeInfo& from, const std::string& to) { return 1; }
+bool Visitor::esTruncamientoPeligroso(const TypeInfo& from, Tipo to) { return 1; }
 
-void TypeCheckerVisitor::warning(const std::string& msg, bool incluirFuncion) {
-    if (incluirFuncion)
-        std::cout << "Advertencia: En función '" << currentFunctionName << "': " << msg << std::endl;
-    else
-        std::cout << "Advertencia: " << msg << std::endl;
+void TypeCheckerVisitor::warning(CodigoDiagnostico codigo, const std::string& msg, bool incluirFuncion) {
+    if (enCodigoMuerto) return;
+    diagnosticos->agregar(SEV_ADVERTENCIA, codigo, posActual, incluirFuncion ? currentFunctionName : "", msg);
     warningCount++;
 }
 
-void TypeCheckerVisitor::error(const std::string& msg, bool incluirFuncion) {
-    if (incluirFuncion)
-        std::cout << "Error: En función '" << currentFunctionName << "': " << msg << std::endl;
-    else
-        std::cout << "Error: " << msg << std::endl;
+void TypeCheckerVisitor::error(CodigoDiagnostico codigo, const std::string& msg, bool incluirFuncion) {
+    if (enCodigoMuerto) return;
+    diagnosticos->agregar(SEV_ERROR, codigo, posActual, incluirFuncion ? currentFunctionName : "", msg);
     errorCount++;
 }
 
@@ -79,133 +51,164 @@ void TypeCheckerVisitor::reset() {
     hasStdio = false;
     errorCount = 0;
     warningCount = 0;
-    functionReturnTypes.clear();
-    currentFunctionType = "";
+    funciones.clear();
+    terminadas.reset();
+    diagnosticos = &salida;
+    indiceActual = 0;
+    currentFunctionType = TIPO_NINGUNO;
+    currentFunction = NO_SYMBOL;
+    posActual = SIN_POSICION;
+    offsetFrame = 0;
+    enCodigoMuerto = false;
+}
+
+// Recorre un bloque que nunca se ejecuta (rama de un if, while o for con condición
+// constante) solo para anotarlo, porque codegen lo genera igual. No reporta nada ni
+// cambia los valores conocidos de las variables.
+void TypeCheckerVisitor::anotarMuerto(Body* b) {
+    bool anterior = enCodigoMuerto;
+    enCodigoMuerto = true;
+    visit(b);
+    enCodigoMuerto = anterior;
 }
 
 void TypeCheckerVisitor::visit(PrintStatement* s) {
     s->countFormatSpecifiers();
+    s->formatos.clear();
     for (const auto& i : s->bools) {
-        if (!mapaFormatoATipo.count(i)) {
-            error("En printf no se acepta '%" + i + "'. Solo se aceptan: " + aceptados, 1);
+        FormatoPrintf f = formatoPrintf(i);
+        if (f == NUM_FORMATOS) {
+            // Se reporta aunque el printf esté en código muerto: codegen no podría emitirlo.
+            bool muerto = enCodigoMuerto;
+            enCodigoMuerto = false;
+            error(DIAG_PRINTF_FORMATO, "En printf no se acepta '%" + i + "'. Solo se aceptan: " + aceptados, 1);
+            enCodigoMuerto = muerto;
             return;
         }
+        s->formatos.push_back(f);
     }
     if(s->bools.size() != s->argumentos.size()){
-        error("En printf se esperaban " + std::to_string (s->bools.size()) + " argumentos pero se encontraron " + std::to_string(s->argumentos.size()), 1);
+        error(DIAG_PRINTF_ARGUMENTOS, "En printf se esperaban " + std::to_string (s->bools.size()) + " argumentos pero se encontraron " + std::to_string(s->argumentos.size()), 1);
         return;
     }
     for (size_t i = 0; i < s->bools.size(); ++i) {
-        std::string esperado = mapaFormatoATipo[s->bools[i]]; 
-        TypeInfo real = s->argumentos[i]->accept(this); 
+        Tipo esperado = tipoFormato[s->formatos[i]];
+        TypeInfo real = dispatch(s->argumentos[i]); 
         if (real.tipo != esperado) {
-            warning("En printf, el argumento " + std::to_string(i+1) +
-                    " esperaba tipo '" + esperado + "', pero se recibió '" + real.tipo + "'", true);
+            warning(DIAG_PRINTF_TIPO, "En printf, el argumento " + std::to_string(i+1) +
+                    " esperaba tipo '" + nombreTipo(esperado) + "', pero se recibió '" + nombreTipo(real.tipo) + "'", true);
         }
     }
 }
 
 TypeInfo TypeCheckerVisitor::visit(UnaryExp* e) {
     if (e->op == POST_INC_OP || e->op == POST_DEC_OP) {
-        if (!env.check(e->id)) {
-            warning("Variable '" + e->id + "' no declarada", true);
-            return TypeInfo("int", 0, false);
+        Variable* var = env.find(e->id);
+        if (!var) {
+            error(DIAG_VARIABLE_NO_DECLARADA, "Variable '" + nombre(e->id) + "' no declarada", true);
+            return TypeInfo(TIPO_INT, 0, false);
         }
-        TypeInfo info = env.lookup(e->id);
-        long valorAnterior = info.valor;
-        bool eraConst = info.isConst;
-        if (e->op == POST_INC_OP)
-            info.valor += 1;
-        else
-            info.valor -= 1;
-        info.isConst = eraConst;
-        env.update(e->id, info);
-        return TypeInfo(info.tipo, valorAnterior, eraConst);
+        e->tipo = var->info.tipo;
+        e->slot = var->slot;
+        TypeInfo* info = &var->info;
+        long valorAnterior = info->valor;
+        if (!enCodigoMuerto)
+            info->valor += e->op == POST_INC_OP ? 1 : -1;
+        return TypeInfo(info->tipo, valorAnterior, info->isConst);
     }
     if (e->op == PRE_INC_OP || e->op == PRE_DEC_OP) {
-        if (!env.check(e->id)) {
-            warning("Variable '" + e->id + "' no declarada", true);
-            return TypeInfo("int", 0, false);
+        Variable* var = env.find(e->id);
+        if (!var) {
+            error(DIAG_VARIABLE_NO_DECLARADA, "Variable '" + nombre(e->id) + "' no declarada", true);
+            return TypeInfo(TIPO_INT, 0, false);
         }
-        TypeInfo info = env.lookup(e->id);
-        bool eraConst = info.isConst;
-        if (e->op == PRE_INC_OP)
-            info.valor += 1;
-        else
-            info.valor -= 1;
-        info.isConst = eraConst;
-        env.update(e->id, info);
-        return TypeInfo(info.tipo, info.valor, eraConst);
+        e->tipo = var->info.tipo;
+        e->slot = var->slot;
+        TypeInfo* info = &var->info;
+        if (!enCodigoMuerto)
+            info->valor += e->op == PRE_INC_OP ? 1 : -1;
+        return TypeInfo(info->tipo, info->valor, info->isConst);
     }
     if (e->expr) {
-        TypeInfo t = e->expr->accept(this);
+        TypeInfo t = dispatch(e->expr);
         long valor = (e->op == NEG_OP) ? -t.valor : +t.valor;
         return TypeInfo(t.tipo, valor, t.isConst, t.origen);
     }
-    return TypeInfo("int", 0, false);
+    return TypeInfo(TIPO_INT, 0, false);
 }
 
 TypeInfo TypeCheckerVisitor::visit(BinaryExp* e) {
     if (e->op == ASSIGN_OP || e->op == PLUS_ASSIGN_OP || e->op == MINUS_ASSIGN_OP) {
-        auto idExp = dynamic_cast<IdentifierExp*>(e->left);
+        auto idExp = node_cast<IdentifierExp>(e->left);
         if (!idExp) {
-            error("La izquierda de una asignación debe ser una variable (identificador)", true);
-            return TypeInfo("int", 0, false);
+            error(DIAG_ASIGNACION_NO_VARIABLE, "La izquierda de una asignación debe ser una variable (identificador)", true);
+            return TypeInfo(TIPO_INT, 0, false);
         }
-        std::string nombre = idExp->name;
-        if (!env.check(nombre)) {
-            warning("Variable '" + nombre + "' no declarada", true);
-            return TypeInfo("int", 0, false);
+        Symbol id = idExp->name;
+        // Las expresiones no declaran variables: el puntero sigue valiendo después de evaluar
+        // la derecha. El valor sí puede cambiar (a += a++), así que se guarda antes.
+        Variable* var = env.find(id);
+        if (!var) {
+            // Error y no advertencia (igual en ++/--): la variable no tiene slot y codegen
+            // escribiría en 0(%rbp), encima del rbp guardado.
+            error(DIAG_VARIABLE_NO_DECLARADA, "Variable '" + nombre(id) + "' no declarada", true);
+            return TypeInfo(TIPO_INT, 0, false);
         }
-        TypeInfo left = env.lookup(nombre);
-        TypeInfo right = e->right->accept(this);
-        if (right.tipo == "??") {
-            return TypeInfo(left.tipo, 0, false);
-        }
-        if ((left.tipo == "unsigned" || left.tipo == "unsigned long") && right.isConst && right.valor < 0) {
-            warning("Asignación de valor negativo a variable de tipo '" + left.tipo + "'", true);
+        idExp->tipo = var->info.tipo;
+        idExp->slot = var->slot;
+        const TypeInfo& left = var->info;
+        const long valorAnterior = left.valor;
+        const bool eraConst = left.isConst;
+        const Symbol origenAnterior = left.origen;
+        TypeInfo right = dispatch(e->right);
+        if (esSinSigno(left.tipo) && right.isConst && right.valor < 0) {
+            warning(DIAG_VALOR_NEGATIVO, "Asignación de valor negativo a variable de tipo '" + nombreTipo(left.tipo) + "'", true);
         }
         long nuevoValor = 0;
         bool isConst = false;
-        std::string origen = right.origen;
+        Symbol origen = right.origen;
         switch (e->op) {
             case ASSIGN_OP:
                 if (esTruncamientoPorTamanio(right.tipo, left.tipo)) {
-                    warning("Asignación con tipos distintos: '" + right.tipo + "' a '" + left.tipo + "'; posible truncamiento", true);
+                    warning(DIAG_TRUNCAMIENTO, "Asignación con tipos distintos: '" + nombreTipo(right.tipo) + "' a '" + nombreTipo(left.tipo) + "'; posible truncamiento", true);
                 }
                 nuevoValor = right.valor;
                 isConst = right.isConst;
                 break;
             case PLUS_ASSIGN_OP:
                 {
-                    std::string tipoResultado = promote(left.tipo, right.tipo);
+                    Tipo tipoResultado = promote(left.tipo, right.tipo);
                     if (esTruncamientoPorTamanio(tipoResultado, left.tipo)) {
-                        warning("Asignación con tipos distintos: '" + tipoResultado + "' a '" + left.tipo + "'; posible truncamiento", true);
+                        warning(DIAG_TRUNCAMIENTO, "Asignación con tipos distintos: '" + nombreTipo(tipoResultado) + "' a '" + nombreTipo(left.tipo) + "'; posible truncamiento", true);
                     }
                 }
-                nuevoValor = left.valor + right.valor;
-                isConst = left.isConst && right.isConst;
-                if (!left.isConst) origen = left.origen;
+                nuevoValor = valorAnterior + right.valor;
+                isConst = eraConst && right.isConst;
+                if (!eraConst) origen = origenAnterior;
                 break;
             case MINUS_ASSIGN_OP:
                 {
-                    std::string tipoResultado = promote(left.tipo, right.tipo);
+                    Tipo tipoResultado = promote(left.tipo, right.tipo);
                     if (esTruncamientoPorTamanio(tipoResultado, left.tipo)) {
-                        warning("Asignación con tipos distintos: '" + tipoResultado + "' a '" + left.tipo + "'; posible truncamiento", true);
+                        warning(DIAG_TRUNCAMIENTO, "Asignación con tipos distintos: '" + nombreTipo(tipoResultado) + "' a '" + nombreTipo(left.tipo) + "'; posible truncamiento", true);
                     }
                 }
-                nuevoValor = left.valor - right.valor;
-                isConst = left.isConst && right.isConst;
-                if (!left.isConst) origen = left.origen;
+                nuevoValor = valorAnterior - right.valor;
+                isConst = eraConst && right.isConst;
+                if (!eraConst) origen = origenAnterior;
                 break;
             default: break;
         }
-        env.update(nombre, TypeInfo(left.tipo, nuevoValor, isConst, isConst ? "" : origen));
-        return TypeInfo(left.tipo, nuevoValor, isConst, isConst ? "" : origen);
+        if (!enCodigoMuerto) {
+            var->info.valor = nuevoValor;
+            var->info.isConst = isConst;
+            var->info.origen = isConst ? NO_SYMBOL : origen;
+        }
+        return var->info;
     }
-    TypeInfo t1 = e->left->accept(this);
-    TypeInfo t2 = e->right->accept(this);
-    std::string resultType = promote(t1.tipo, t2.tipo);
+    TypeInfo t1 = dispatch(e->left);
+    TypeInfo t2 = dispatch(e->right);
+    Tipo resultType = promote(t1.tipo, t2.tipo);
     if (t1.isConst && t2.isConst) {
         long result = 0;
         switch (e->op) {
@@ -223,14 +226,21 @@ TypeInfo TypeCheckerVisitor::visit(BinaryExp* e) {
         }
         return TypeInfo(resultType, result, true);
     }
-    std::string origen = !t1.isConst ? t1.origen : (!t2.isConst ? t2.origen : "");
+    Symbol origen = !t1.isConst ? t1.origen : (!t2.isConst ? t2.origen : NO_SYMBOL);
     return TypeInfo(resultType, 0, false, origen);
 }
 
 TypeInfo TypeCheckerVisitor::visit(IdentifierExp* e) {
-    if (!env.check(e->name))
-        error("Variable '" + e->name + "' no declarada", 1);
-    TypeInfo t = env.lookup(e->name);
+    Variable* var = env.find(e->name);
+    if (!var) {
+        error(DIAG_VARIABLE_NO_DECLARADA, "Variable '" + nombre(e->name) + "' no declarada", 1);
+        TypeInfo t;
+        t.origen = e->name;
+        return t;
+    }
+    e->tipo = var->info.tipo;
+    e->slot = var->slot;
+    TypeInfo t = var->info;
     t.origen = e->name;
     return t;
 }
@@ -239,230 +249,362 @@ TypeInfo TypeCheckerVisitor::visit(FCallExp* e) {
     std::vector<TypeInfo> tiposArgs;
     for (Exp* arg : e->argumentos) {
         if (arg)
-            tiposArgs.push_back(arg->accept(this));
-    }
-    if (!functionReturnTypes.count(e->nombre)) {
-        error("Función '" + e->nombre + "' no existe", 0);
-        return TypeInfo("int", 0, false);
-    }
-    if (functionParamTypes.count(e->nombre)) {
-        const auto& tiposEsperados = functionParamTypes[e->nombre];
-        if (tiposEsperados.size() != tiposArgs.size()) {
-            error("En función '" + currentFunctionName + "': la función '" + e->nombre +
-                  "' espera " + std::to_string(tiposEsperados.size()) + " argumento(s), pero recibió " +
-                  std::to_string(tiposArgs.size()), 0);
-        } else {
-            for (size_t i = 0; i < tiposArgs.size(); ++i) {
-                if (tiposArgs[i].tipo != tiposEsperados[i]) {
-                    warning("En función '" + currentFunctionName + "': el argumento " +
-                            std::to_string(i + 1) + " de '" + e->nombre +
-                            "' esperaba '" + tiposEsperados[i] +
-                            "', pero recibió '" + tiposArgs[i].tipo + "'", 0);
-                }
+            tiposArgs.push_back(dispatch(arg));
+    }
+    FunctionInfo* f = funcion(e->nombre);
+    if (!f) {
+        error(DIAG_FUNCION_NO_EXISTE, "Función '" + nombre(e->nombre) + "' no existe", 0);
+        return TypeInfo(TIPO_INT, 0, false);
+    }
+    e->tipoRetorno = f->tipoRetorno;
+    // Una función anterior se ve con el valor de retorno que dejó su chequeo, como en un
+    // recorrido en orden; de una posterior (o de esta misma) no se espera nada.
+    bool anterior = f->indice >= 0 && f->indice < indiceActual;
+    if (anterior && raiz->terminadas) esperarCuerpo(f->indice);
+    const auto& tiposEsperados = f->tiposParametros;
+    if (tiposEsperados.size() != tiposArgs.size()) {
+        error(DIAG_LLAMADA_ARGUMENTOS, "la función '" + nombre(e->nombre) +
+              "' espera " + std::to_string(tiposEsperados.size()) + " argumento(s), pero recibió " +
+              std::to_string(tiposArgs.size()), true);
+    } else {
+        for (size_t i = 0; i < tiposArgs.size(); ++i) {
+            if (tiposArgs[i].tipo != tiposEsperados[i]) {
+                warning(DIAG_LLAMADA_TIPO, "el argumento " +
+                        std::to_string(i + 1) + " de '" + nombre(e->nombre) +
+                        "' esperaba '" + nombreTipo(tiposEsperados[i]) +
+                        "', pero recibió '" + nombreTipo(tiposArgs[i].tipo) + "'", true);
             }
         }
     }
-    std::string tipoRet = functionReturnTypes[e->nombre];
-    if (functionReturnValues.count(e->nombre)) {
-        TypeInfo info = functionReturnValues[e->nombre];
-        return TypeInfo(tipoRet, info.valor, info.isConst);
-    }
-    return TypeInfo(tipoRet, 0, true);
+    if ((anterior || f->indice == indiceActual) && f->retornaConstante)
+        return TypeInfo(f->tipoRetorno, f->valorRetorno, true);
+    return TypeInfo(f->tipoRetorno, 0, false);
 }
 
 void TypeCheckerVisitor::visit(VarDec* v) {
+    v->slot = offsetFrame - 8;
     for (const auto& p : v->vars) {
-        const std::string& id = p.first;
+        Symbol sym = p.first;
+        std::string id = nombre(sym);
         Exp* init = p.second;
-        if (env.checkCurrentLevel(id))
-            warning("En función '" + currentFunctionName + "': variable redeclarada: " + id, 0);
-        if (functionReturnTypes.count(id))
-            error("En función '" + currentFunctionName + "': el nombre '" + id + "' ya fue usado como nombre de función", 0);
+        if (env.checkCurrentLevel(sym))
+            warning(DIAG_REDECLARACION, "variable redeclarada: " + id, true);
+        if (funcion(sym))
+            error(DIAG_NOMBRE_DE_FUNCION, "el nombre '" + id + "' ya fue usado como nombre de función", true);
         TypeInfo tipoFinal = TypeInfo(v->tipo);
         if (init) {
-            TypeInfo tipoInit = init->accept(this);
-            if (tipoInit.tipo == "void") {
-                error("En función '" + currentFunctionName + "': no se puede inicializar variable '" + id + "' con valor de tipo void.", 0);
+            TypeInfo tipoInit = dispatch(init);
+            if (tipoInit.tipo == TIPO_VOID) {
+                error(DIAG_INICIALIZACION, "no se puede inicializar variable '" + id + "' con valor de tipo void.", true);
             }
             if (!tipoInit.isConst) {
-                error("En función '" + currentFunctionName + "': variable '" + id + "' usa la variable '" + tipoInit.origen + "' que no es constante", 0);
+                error(DIAG_INICIALIZACION, "variable '" + id + "' usa la variable '" + nombre(tipoInit.origen) + "' que no es constante", true);
             }
-            if ((v->tipo == "unsigned" || v->tipo == "unsigned long") && tipoInit.valor < 0) {
-                warning("En función '" + currentFunctionName + "': asignación de valor negativo a variable '" + id + "' de tipo '" + v->tipo + "'", 0);
+            if (esSinSigno(v->tipo) && tipoInit.valor < 0) {
+                warning(DIAG_VALOR_NEGATIVO, "asignación de valor negativo a variable '" + id + "' de tipo '" + nombreTipo(v->tipo) + "'", true);
             }
             if (esTruncamientoPorTamanio(tipoInit.tipo, v->tipo)) {
-                warning("En función '" + currentFunctionName + "': inicialización de variable '" + id +
-                        "' de tipo '" + v->tipo + "' con valor de tipo '" + tipoInit.tipo +
+                warning(DIAG_TRUNCAMIENTO, "inicialización de variable '" + id +
+                        "' de tipo '" + nombreTipo(v->tipo) + "' con valor de tipo '" + nombreTipo(tipoInit.tipo) +
                         (tipoInit.isConst ? (" (" + std::to_string(tipoInit.valor) + ")") : "") +
-                        "'; posible truncamiento", 0);
+                        "'; posible truncamiento", true);
             }
             tipoFinal = TypeInfo(v->tipo, tipoInit.valor, tipoInit.isConst, tipoInit.origen);
         }
-        env.add_var(id, tipoFinal);
+        offsetFrame -= 8;
+        env.add_var(sym, Variable{tipoFinal, offsetFrame});
     }
 }
 
 void TypeCheckerVisitor::visit(ReturnStatement* s) {
-    hasReturn = true;
+    if (!enCodigoMuerto) hasReturn = true;
     if (!s->e) {
-        if (currentFunctionType != "void") {
-            error("Espera un valor de retorno (" + currentFunctionType + "), pero no se retornó nada.", 1);
+        if (currentFunctionType != TIPO_VOID) {
+            error(DIAG_RETORNO_FALTANTE, "Espera un valor de retorno (" + nombreTipo(currentFunctionType) + "), pero no se retornó nada.", 1);
         }
         return;
     }
-    TypeInfo tipoRet = s->e->accept(this);
-    if (currentFunctionType == "void") {
-        error("En función '" + currentFunctionName + "': no se puede retornar un valor en una función void.", 0);
+    TypeInfo tipoRet = dispatch(s->e);
+    if (currentFunctionType == TIPO_VOID) {
+        error(DIAG_RETORNO_EN_VOID, "no se puede retornar un valor en una función void.", true);
         return;
     }
     if (tipoRet.isConst && esTruncamientoPorTamanio(tipoRet.tipo, currentFunctionType)) {
-        warning("En función '" + currentFunctionName + "': valor retornado constante de tipo '" + tipoRet.tipo +
-                "' asignado a tipo '" + currentFunctionType +
-                "'; posible truncamiento", 0);
+        warning(DIAG_TRUNCAMIENTO, "valor retornado constante de tipo '" + nombreTipo(tipoRet.tipo) +
+                "' asignado a tipo '" + nombreTipo(currentFunctionType) +
+                "'; posible truncamiento", true);
     }
-    if ((currentFunctionType == "unsigned" || currentFunctionType == "unsigned long") && tipoRet.isConst && tipoRet.valor < 0) {
-        warning("En función '" + currentFunctionName + "': se retorna un valor negativo hacia un '" + currentFunctionType + "' posible casteo", 0);
+    if (esSinSigno(currentFunctionType) && tipoRet.isConst && tipoRet.valor < 0) {
+        warning(DIAG_VALOR_NEGATIVO, "se retorna un valor negativo hacia un '" + nombreTipo(currentFunctionType) + "' posible casteo", true);
     }
-    bool tiposnoCompatibles =(currentFunctionType == "int" && (tipoRet.tipo == "long" || tipoRet.tipo == "unsigned long" )) ||
-                            (currentFunctionType == "unsigned" && (tipoRet.tipo == "long" || tipoRet.tipo == "unsigned long" ));
+    bool tiposnoCompatibles = bitsDe(currentFunctionType) == 32 && bitsDe(tipoRet.tipo) == 64;
     if (tiposnoCompatibles) {
-        warning("En función '" + currentFunctionName + "': tipo retornado '" + tipoRet.tipo +
-                "' no coincide con el tipo esperado '" + currentFunctionType + "'", 0);
+        warning(DIAG_RETORNO_TIPO, "tipo retornado '" + nombreTipo(tipoRet.tipo) +
+                "' no coincide con el tipo esperado '" + nombreTipo(currentFunctionType) + "'", true);
     }
-    if (tipoRet.isConst) {
-        functionReturnValues[currentFunctionName] = tipoRet;
+    if (tipoRet.isConst && !enCodigoMuerto) {
+        if (FunctionInfo* f = funcion(currentFunction)) {
+            f->retornaConstante = true;
+            f->valorRetorno = tipoRet.valor;
+        }
     }
 }
 
-void TypeCheckerVisitor::visit(FunDec* f) {
-    if (functionReturnTypes.count(f->nombre)) {
-        error("Redefinición de la función '" + f->nombre + "'",0);
-        return;
+// Primera fase: deja la firma de f en la tabla. Devuelve false si el cuerpo no se
+// chequea (redefinición o parámetros mal formados).
+bool TypeCheckerVisitor::registrarFirma(FunDec* f) {
+    std::string nombreF = nombre(f->nombre);
+    posActual = f->pos;
+    if (funcion(f->nombre)) {
+        error(DIAG_REDEFINICION_FUNCION, "Redefinición de la función '" + nombreF + "'",0);
+        return false;
     }
     if (env.check(f->nombre)) {
-        error("El nombre de función '" + f->nombre + "' ya fue usado como variable",0);
-        return;
+        error(DIAG_NOMBRE_DE_FUNCION, "El nombre de función '" + nombreF + "' ya fue usado como variable",0);
+        return false;
     }
-    functionReturnTypes[f->nombre] = f->tipo;
-    functionParamTypes[f->nombre] = f->tipos;
-    currentFunctionType = f->tipo;
-    currentFunctionName = f->nombre;
-    hasReturn = false;
+    FunctionInfo& info = raiz->funciones[f->nombre];
+    info.declarada = true;
+    info.tipoRetorno = f->tipo;
+    info.tiposParametros = f->tipos;
     if (f->parametros.size() != f->tipos.size()) {
-        error("La función '" + f->nombre + "' tiene distinta cantidad de parámetros y tipos.",0);
-        return;
+        error(DIAG_PARAMETROS, "La función '" + nombreF + "' tiene distinta cantidad de parámetros y tipos.",0);
+        return false;
     }
+    return true;
+}
+
+void TypeCheckerVisitor::chequearCuerpo(FunDec* f) {
+    std::string nombreF = nombre(f->nombre);
+    TRAZA(CHEQUEO, INFO, "función " << nombreF << " (" << f->parametros.size() << " parámetros)");
+    posActual = f->pos;
+    indiceActual = funcion(f->nombre)->indice;
+    currentFunctionType = f->tipo;
+    currentFunctionName = nombreF;
+    currentFunction = f->nombre;
+    hasReturn = false;
     env.add_level();
-    for (size_t i = 0; i < f->parametros.size(); ++i)
-        env.add_var(f->parametros[i], TypeInfo(f->tipos[i], 0, true));
+    offsetFrame = 0;
+    for (size_t i = 0; i < f->parametros.size(); ++i) {
+        offsetFrame -= 8;
+        env.add_var(f->parametros[i], Variable{TypeInfo(f->tipos[i], 0, true), offsetFrame});
+    }
     if (f->cuerpo)
-        f->cuerpo->accept(this);
-    if (currentFunctionType != "void" && f->nombre != "main" && !hasReturn)
-        error("La función '" + f->nombre + "' no retorna ningún valor de tipo '" + currentFunctionType + "'",0);
+        visit(f->cuerpo);
+    if (currentFunctionType != TIPO_VOID && nombreF != "main" && !hasReturn)
+        error(DIAG_RETORNO_FALTANTE, "La función '" + nombreF + "' no retorna ningún valor de tipo '" + nombreTipo(currentFunctionType) + "'",0);
+    env.remove_level();
+}
+
+void TypeCheckerVisitor::chequearMain(Program* p, int indice) {
+    currentFunctionType = TIPO_INT;
+    currentFunctionName = "main";
+    currentFunction = NO_SYMBOL;
+    indiceActual = indice;
+    posActual = p->posMain;
+    offsetFrame = 0;
+    hasReturn = false;
+    env.add_level();
+    visit(p->mainBody);
     env.remove_level();
+    if (!hasReturn)
+        warning(DIAG_MAIN_SIN_RETURN, "La función 'main' no tiene un return; se asume return 0 por defecto", 0);
+}
+
+void TypeCheckerVisitor::esperarCuerpo(int indice) {
+    std::atomic<bool>& listo = raiz->terminadas[indice];
+    if (listo.load(std::memory_order_acquire)) return;
+    std::unique_lock<std::mutex> lock(raiz->mutexTerminadas);
+    raiz->cvTerminadas.wait(lock, [&] { return listo.load(std::memory_order_acquire); });
+}
+
+void TypeCheckerVisitor::marcarTerminada(int indice) {
+    {
+        std::lock_guard<std::mutex> lock(mutexTerminadas);
+        terminadas[indice].store(true, std::memory_order_release);
+    }
+    cvTerminadas.notify_all();
+}
+
+// Registra la firma y chequea el cuerpo, como si f fuera la única función pendiente.
+void TypeCheckerVisitor::visit(FunDec* f) {
+    if (raiz->funciones.size() < simbolos.size()) raiz->funciones.resize(simbolos.size());
+    if (!registrarFirma(f)) return;
+    funcion(f->nombre)->indice = indiceActual;
+    chequearCuerpo(f);
 }
 
 void TypeCheckerVisitor::visit(Program* p) {
+    chequearParalelo(p, 1);
+}
+
+void TypeCheckerVisitor::chequearParalelo(Program* p, unsigned hilos) {
+    registrarFirmas(p);
+
+    // Fase 2: cuerpos. paraleloPara reparte los índices en orden creciente, así que una
+    // función que espera a otra anterior siempre espera a una que ya está en curso.
+    size_t n = p->Fundecs.size();
+    std::vector<std::unique_ptr<TypeCheckerVisitor>> trabajadores;
+    for (unsigned h = 0; h < std::max(1u, std::min<unsigned>(hilos, n + 1)); ++h)
+        trabajadores.push_back(std::unique_ptr<TypeCheckerVisitor>(new TypeCheckerVisitor(*this)));
+    paraleloPara(n + 1, hilos, [&](size_t i, unsigned h) {
+        struct Marca {
+            TypeCheckerVisitor* raiz;
+            int indice;
+            ~Marca() { raiz->marcarTerminada(indice); }
+        } marca{this, int(i)};
+        TypeCheckerVisitor& c = *trabajadores[h];
+        if (!porFuncion[i]) porFuncion[i].reset(new Diagnosticos);
+        c.diagnosticos = porFuncion[i].get();
+        if (i < n) {
+            if (conCuerpo[i]) c.chequearCuerpo(p->Fundecs[i]);
+        } else if (p->mainBody) {
+            c.chequearMain(p, int(n));
+        }
+    });
+
+    for (size_t i = 0; i <= n; ++i) salida.agregarTodos(*porFuncion[i]);
+    for (const std::unique_ptr<TypeCheckerVisitor>& c : trabajadores) {
+        errorCount += c->errorCount;
+        warningCount += c->warningCount;
+    }
+}
+
+// Modo flujo: el cuerpo i se chequea en este hilo apenas se parsea, después de los
+// anteriores, así que sus diagnósticos van directo a la salida, detrás de los de su firma.
+void TypeCheckerVisitor::chequearEnFlujo(size_t i, FunDec* f, Program* p) {
+    size_t n = conCuerpo.size();
+    if (i > n) return;
+    if (porFuncion[i]) {
+        salida.agregarTodos(*porFuncion[i]);
+        porFuncion[i].reset();
+    }
+    if (f) {
+        if (i < n && conCuerpo[i]) chequearCuerpo(f);
+    } else if (p && p->mainBody) {
+        chequearMain(p, int(n));
+    }
+    marcarTerminada(int(i));
+}
+
+void TypeCheckerVisitor::registrarFirmas(Program* p) {
+    funciones.assign(simbolos.size(), FunctionInfo());
     hasStdio = false;
     for (const std::string& inc : p->includes) {
         if (inc == "stdio.h") hasStdio = true;
     }
     if (!hasStdio)
-        warning("Falta #include<stdio.h>",0);
-    for (FunDec* f : p->Fundecs)
-        f->accept(this);
-    if (p->mainBody) {
-        currentFunctionType = "int";
-        currentFunctionName = "main";
-        hasReturn = false;
-        env.add_level();
-        p->mainBody->accept(this);
-        env.remove_level();
-        if (!hasReturn)
-            warning("La función 'main' no tiene un return; se asume return 0 por defecto", 0);
+        warning(DIAG_FALTA_STDIO, "Falta #include<stdio.h>",0);
+
+    // Fase 1, en orden: firmas. Sus errores van al buffer de cada función para que
+    // salgan antes que los de su cuerpo, como en un recorrido secuencial.
+    // Casi ninguna firma tiene errores, así que el buffer se crea solo si hace falta.
+    size_t n = p->Fundecs.size();
+    porFuncion.clear();
+    porFuncion.resize(n + 1);
+    conCuerpo.assign(n, 0);
+    terminadas.reset(new std::atomic<bool>[n + 1]);
+    for (size_t i = 0; i <= n; ++i) terminadas[i].store(false, std::memory_order_relaxed);
+    Diagnosticos firma;
+    diagnosticos = &firma;
+    for (size_t i = 0; i < n; ++i) {
+        FunDec* f = p->Fundecs[i];
+        conCuerpo[i] = registrarFirma(f);
+        if (conCuerpo[i]) funciones[f->nombre].indice = int(i);
+        else terminadas[i].store(true, std::memory_order_relaxed);
+        if (firma.size()) {
+            porFuncion[i].reset(new Diagnosticos);
+            porFuncion[i]->agregarTodos(firma);
+            firma.clear();
+        }
     }
+    diagnosticos = &salida;
 }
 
 void TypeCheckerVisitor::visit(ExpressionStatement* s) {
     if (s->expr) {
-        s->expr->accept(this);
+        dispatch(s->expr);
     }
 }
 
-TypeInfo TypeCheckerVisitor::visit(NumberExp* e) { return TypeInfo("int", e->value, true); }
+TypeInfo TypeCheckerVisitor::visit(NumberExp* e) { return TypeInfo(TIPO_INT, e->value, true); }
 
 void TypeCheckerVisitor::visit(Body* b) {
+    // Al volver del bloque, los diagnósticos de la sentencia que lo contiene (if, for,
+    // función) llevan otra vez la posición de esa sentencia.
+    uint32_t posAnterior = posActual;
     env.add_level();
-    for (Stm* stm : b->stms)
-        stm->accept(this);
+    for (Stm* stm : b->stms) {
+        if (stm->pos != SIN_POSICION) posActual = stm->pos;
+        dispatch(stm);
+    }
     env.remove_level();
+    posActual = posAnterior;
 }
 
 void TypeCheckerVisitor::visit(IfStatement* s) {
-    TypeInfo cond = s->condition->accept(this);
-    if (cond.isConst) {
-        if (cond.valor) {
-            env.add_level();
-            if (s->then) s->then->accept(this);
-            env.remove_level();
-        } else {
-            env.add_level();
-            if (s->els) s->els->accept(this);
-            env.remove_level();
-        }
-    } else {
-        env.add_level();
-        if (s->then) s->then->accept(this);
-        env.remove_level();
-        env.add_level();
-        if (s->els) s->els->accept(this);
-        env.remove_level();
+    TypeInfo cond = dispatch(s->condition);
+    env.add_level();
+    if (s->then) {
+        if (cond.isConst && !cond.valor) anotarMuerto(s->then);
+        else visit(s->then);
+    }
+    env.remove_level();
+    env.add_level();
+    if (s->els) {
+        if (cond.isConst && cond.valor) anotarMuerto(s->els);
+        else visit(s->els);
     }
+    env.remove_level();
 }
 
 void TypeCheckerVisitor::visit(WhileStatement* s) {
-    TypeInfo cond = s->condition->accept(this);
+    TypeInfo cond = dispatch(s->condition);
     if (cond.isConst && cond.valor == 0) {
-        warning("En función '" + currentFunctionName + "': bucle 'while' con condición siempre falsa; cuerpo nunca se ejecutará", 0);
+        warning(DIAG_CONDICION_FALSA, "bucle 'while' con condición siempre falsa; cuerpo nunca se ejecutará", true);
+        if (s->b) anotarMuerto(s->b);
     } else {
-        if (s->b) s->b->accept(this);
+        if (s->b) visit(s->b);
     }
 }
 
 void TypeCheckerVisitor::visit(ForStatement* s) {
+    // Las variables del for liberan su lugar en el frame al terminar el bucle.
+    int offsetAnterior = offsetFrame;
     env.add_level();
     if (s->varInit)
-        s->varInit->accept(this);
+        visit(s->varInit);
     if (s->init)
-        s->init->accept(this);
+        dispatch(s->init);
     TypeInfo cond;
     if (s->cond)
-        cond = s->cond->accept(this);
+        cond = dispatch(s->cond);
     if (s->update)
-        s->update->accept(this);
+        dispatch(s->update);
     if (cond.isConst && cond.valor == 0) {
-        warning("En función '" + currentFunctionName + "': bucle 'for' con condición siempre falsa; cuerpo nunca se ejecutará", 0);
+        warning(DIAG_CONDICION_FALSA, "bucle 'for' con condición siempre falsa; cuerpo nunca se ejecutará", true);
+        if (s->body)
+            anotarMuerto(s->body);
     } else {
         if (s->body)
-            s->body->accept(this);
+            visit(s->body);
     }
     env.remove_level();
+    offsetFrame = offsetAnterior;
 }
 
 void CodeGenVisitor::emit(const std::string& instruction) {
-    if (!firstPass) {
-        out << "    " << instruction << "\n";
-    }
+    out << "    " << instruction << "\n";
 }
 
-void CodeGenVisitor::emit_op(const std::string& op, const std::string& a, const std::string& b, const std::string& tipo) {
-    if (firstPass) return;
-    std::string sufijo = (tipo == "int" || tipo == "unsigned") ? "l" : "q";
+void CodeGenVisitor::emit_op(const std::string& op, const std::string& a, const std::string& b, Tipo tipo) {
+    bool de32 = bitsDe(tipo) == 32;
+    std::string sufijo = de32 ? "l" : "q";
     bool unary = (op == "neg" || op == "push" || op == "pop" || op == "not");
     auto format_reg = [&](const std::string& r) -> std::string {
         std::string result = r;
         if (result[0] != '%') result = "%" + result;
-        if (tipo == "int" || tipo == "unsigned")
+        if (de32)
             result.replace(1, 1, "e");
         else
             result.replace(1, 1, "r");
@@ -487,57 +629,25 @@ void CodeGenVisitor::emit_op(const std::string& op, const std::string& a, const
     emit(op + sufijo + " " + src + ", " + dst);
 }
 
-static int countVarDecsInBody(Body* b) {
-    int cnt = 0;
-    for (Stm* s : b->stms) {
-        if (auto vd = dynamic_cast<VarDec*>(s)) {
-            cnt += vd->vars.size();
-        }
-        else if (auto iff = dynamic_cast<IfStatement*>(s)) {
-            cnt += countVarDecsInBody(iff->then);
-            if (iff->els) cnt += countVarDecsInBody(iff->els);
-        }
-        else if (auto wh = dynamic_cast<WhileStatement*>(s)) {
-            cnt += countVarDecsInBody(wh->b);
-        }
-        else if (auto fr = dynamic_cast<ForStatement*>(s)) {
-            if (fr->varInit) 
-                cnt += fr->varInit->vars.size();
-            cnt += countVarDecsInBody(fr->body);
-        }
-    }
-    return cnt;
-}
-
 void CodeGenVisitor::emit_label(const std::string& label) {
-    if (!firstPass) {
-        out << label << ":\n";
-    }
+    out << label << ":\n";
 }
 
 std::string CodeGenVisitor::new_label(const std::string& prefix) {
     return prefix + std::to_string(labelcont++);
 }
 
-void CodeGenVisitor::emit_truncation(const std::string& from_type, const std::string& to_type) {
-    if (firstPass) return;
-    if ((from_type == "long" && to_type == "int") ||
-        (from_type == "unsigned long" && to_type == "unsigned")) {
-        out << "    # Truncating from " << from_type << " to " << to_type << "\n";
-        out << "    movl %eax, %eax\n";
-    }
-    else if ((from_type == "unsigned long" && to_type == "int") ||
-             (from_type == "long" && to_type == "unsigned")) {
-        out << "    # Truncating from " << from_type << " to " << to_type << "\n";
+void CodeGenVisitor::emit_truncation(Tipo from_type, Tipo to_type) {
+    if (esTruncamientoPorTamanio(from_type, to_type)) {
+        out << "    # Truncating from " << nombreTipo(from_type) << " to " << nombreTipo(to_type) << "\n";
         out << "    movl %eax, %eax\n";
     }
 }
 
-void CodeGenVisitor::emit_unsigned_conversion(long value, const std::string& target_type) {
-    if (firstPass) return;
-    if (value < 0 && (target_type == "unsigned" || target_type == "unsigned long")) {
+void CodeGenVisitor::emit_unsigned_conversion(long value, Tipo target_type) {
+    if (value < 0 && esSinSigno(target_type)) {
         out << "    # Converting negative value to unsigned\n";
-        if (target_type == "unsigned") {
+        if (bitsDe(target_type) == 32) {
             out << "    movl $" << (unsigned int)value << ", %eax\n";
         } else {
             out << "    movq $" << (unsigned long)value << ", %rax\n";
@@ -545,50 +655,49 @@ void CodeGenVisitor::emit_unsigned_conversion(long value, const std::string& tar
     }
 }
 
-std::string CodeGenVisitor::get_printf_format(const std::string& tipo) {
-    if (tipo == "int") return "%d";
-    else if (tipo == "long") return "%ld";
-    else if (tipo == "unsigned") return "%u";
-    else if (tipo == "unsigned long") return "%lu";
-    else return "%d";
-}
-
-std::string CodeGenVisitor::get_printf_label(const std::string& tipo) {
-    if (tipo == "int") return "print_fmt_int";
-    else if (tipo == "long") return "print_fmt_long";
-    else if (tipo == "unsigned") return "print_fmt_uint";
-    else if (tipo == "unsigned long") return "print_fmt_ulong";
-    else return "print_fmt_int";
+std::string CodeGenVisitor::get_printf_format(Tipo tipo) {
+    static const char* formatos[NUM_TIPOS] = {"%d", "%d", "%d", "%u", "%ld", "%lu", "%d", "%d"};
+    return formatos[tipo & (NUM_TIPOS - 1)];
 }
 
-void CodeGenVisitor::register_printf_format(const std::string& tipo) {
-    formatosUsados.insert(tipo);
-    std::cout << "[DEBUG] Registrado formato: " << tipo << std::endl;
+std::string CodeGenVisitor::get_printf_label(Tipo tipo) {
+    static const char* etiquetas[NUM_TIPOS] = {
+        "print_fmt_int", "print_fmt_int", "print_fmt_int", "print_fmt_uint",
+        "print_fmt_long", "print_fmt_ulong", "print_fmt_int", "print_fmt_int"
+    };
+    return etiquetas[tipo & (NUM_TIPOS - 1)];
 }
 
+// Sección .data con los formatos que usó el programa; va en destino antes del .text.
+// Siempre salieron en el orden de un unordered_set llenado en orden de primer uso, y
+// se mantiene ese orden para que el .s no cambie.
 void CodeGenVisitor::generate_used_formats() {
     if (!formatosUsados.empty()) {
-        out << ".data\n";
-        for (const std::string& spec : formatosUsados) {
+        std::unordered_set<std::string> specs;
+        for (FormatoPrintf formato : formatosUsados) specs.insert(textoFormato[formato]);
+        destino << ".data\n";
+        for (const std::string& spec : specs) {
             std::string label = "print_fmt_" + spec;
-            out << label << ": .string \"%" << spec << " \\n\"\n";
+            destino << label << ": .string \"%" << spec << " \\n\"\n";
         }
-        out << "\n";
+        destino << "\n";
     }
 }
 
 void CodeGenVisitor::visit(PrintStatement* s) {
-    s->countFormatSpecifiers();
     for (size_t i = 0; i < s->argumentos.size(); ++i) {
-        TypeInfo arg = s->argumentos[i]->accept(this);
-        std::string spec = s->bools[i];
-        formatosUsados.insert(spec);
-        if (spec == "d" || spec == "u") {
+        TypeInfo arg = dispatch(s->argumentos[i]);
+        FormatoPrintf formato = s->formatos[i];
+        if (!(formatosVistos & (1u << formato))) {
+            formatosVistos |= 1u << formato;
+            formatosUsados.push_back(formato);
+        }
+        if (formato == FORMATO_D || formato == FORMATO_U) {
             emit("movl %eax, %esi");
         } else {
             emit("movq %rax, %rsi");
         }
-        std::string label = "print_fmt_" + spec;
+        std::string label = std::string("print_fmt_") + textoFormato[formato];
         emit("leaq " + label + "(%rip), %rdi");
         emit("movl $0, %eax");
         emit("call printf@PLT");
@@ -597,28 +706,27 @@ void CodeGenVisitor::visit(PrintStatement* s) {
 
 TypeInfo CodeGenVisitor::visit(NumberExp* e) {
     if (e->value >= INT_MIN && e->value <= INT_MAX) {
-        emit_op("mov",to_string(e->value),"rax","long");
-        return TypeInfo("int", e->value, true);
+        emit_op("mov",to_string(e->value),"rax",TIPO_LONG);
+        return TypeInfo(TIPO_INT, e->value, true);
     } else {
-        emit_op("mov",to_string(e->value),"rax","long");
-        return TypeInfo("long", e->value, true);
+        emit_op("mov",to_string(e->value),"rax",TIPO_LONG);
+        return TypeInfo(TIPO_LONG, e->value, true);
     }
 }
 
 TypeInfo CodeGenVisitor::visit(IdentifierExp* e) {
-    if (!memoria.count(e->name)) {
-        std::cerr << "Variable no encontrada: " << e->name << std::endl;
+    if (!e->slot) {
+        std::cerr << "Variable no encontrada: " << simbolos.name(e->name) << std::endl;
     }
-    int offsetVar = memoria[e->name];
-    emit_op("mov",std::to_string(offsetVar) + "(%rbp)","rax",tiposVariables[e->name]);
-    return TypeInfo(tiposVariables[e->name], 0, true, e->name);
+    emit_op("mov",std::to_string(e->slot) + "(%rbp)","rax",e->tipo);
+    return TypeInfo(e->tipo, 0, true, e->name);
 }
 
 TypeInfo CodeGenVisitor::visit(UnaryExp* e) {
-    string tipe = tiposVariables[e->id];
+    Tipo tipe = e->tipo;
     if (e->op == PRE_INC_OP || e->op == PRE_DEC_OP ||
         e->op == POST_INC_OP|| e->op == POST_DEC_OP) {
-        string off = to_string(memoria[e->id]) + "(%rbp)";
+        string off = to_string(e->slot) + "(%rbp)";
         if (e->op == POST_INC_OP || e->op == POST_DEC_OP) {
             emit_op("mov",off,"rax",tipe);
             if (e->op == POST_INC_OP)
@@ -633,63 +741,50 @@ TypeInfo CodeGenVisitor::visit(UnaryExp* e) {
                 emit_op("dec",off,"rax",tipe);
             emit_op("mov",off,"rax",tipe);
         }
-        return TypeInfo(tiposVariables[e->id], 0, false, e->id);
+        return TypeInfo(tipe, 0, false, e->id);
     }
     if (e->expr) {
-        TypeInfo operand = e->expr->accept(this);
+        TypeInfo operand = dispatch(e->expr);
         if (e->op == NEG_OP) {
             emit_op("neg","rax","",tipe);
         }
         return TypeInfo(operand.tipo, -operand.valor, operand.isConst,operand.origen);
     }
-    return TypeInfo("int", 0, false);
+    return TypeInfo(TIPO_INT, 0, false);
 }
 
 TypeInfo CodeGenVisitor::visit(BinaryExp* e) {
     if (e->op == ASSIGN_OP || e->op == PLUS_ASSIGN_OP || e->op == MINUS_ASSIGN_OP) {
-        auto idExp = dynamic_cast<IdentifierExp*>(e->left);
+        auto idExp = node_cast<IdentifierExp>(e->left);
         if (!idExp) {
-            if (!firstPass) {
-                out << "    # ERROR: Left side of assignment must be identifier\n";
-            }
-            return TypeInfo("int", 0, false);
+            out << "    # ERROR: Left side of assignment must be identifier\n";
+            return TypeInfo(TIPO_INT, 0, false);
         }
-        if (firstPass) {
-            TypeInfo right = e->right->accept(this);
-            return right;
-        }
-        TypeInfo right = e->right->accept(this);
-        std::string tipoDestino = "int";
-        if (tiposVariables.count(idExp->name)) {
-            tipoDestino = tiposVariables[idExp->name];
-        }
-        if (right.esNegativo() && TypeInfo(tipoDestino).esTipoSinSigno()) {
+        TypeInfo right = dispatch(e->right);
+        Tipo tipoDestino = idExp->tipo == TIPO_NINGUNO ? TIPO_INT : idExp->tipo;
+        if (right.esNegativo() && esSinSigno(tipoDestino)) {
             emit_unsigned_conversion(right.valor, tipoDestino);
         }
         emit_truncation(right.tipo, tipoDestino);
-        string mem = std::to_string(memoria[idExp->name]) + "(%rbp)";
-        string tip = tiposVariables[idExp->name];
-        if (memoria.count(idExp->name)) {
-            switch (e->op) {
-                case ASSIGN_OP:
-                    emit_op("mov","rax",mem,tip);
-                    break;
-                case PLUS_ASSIGN_OP:
-                    emit_op("add","rax",mem,tip);
-                    break;
-                case MINUS_ASSIGN_OP:
-                    emit_op("sub","rax",mem,tip);
-                    break;
-            }
-        } else {
-            out << "    # ERROR: Variable '" << idExp->name << "' not found for assignment\n";
+        string mem = std::to_string(idExp->slot) + "(%rbp)";
+        Tipo tip = idExp->tipo;
+        switch (e->op) {
+            case ASSIGN_OP:
+                emit_op("mov","rax",mem,tip);
+                break;
+            case PLUS_ASSIGN_OP:
+                emit_op("add","rax",mem,tip);
+                break;
+            case MINUS_ASSIGN_OP:
+                emit_op("sub","rax",mem,tip);
+                break;
         }
         return right;
     }
-    TypeInfo left = e->left->accept(this);
+    TypeInfo left = dispatch(e->left);
     emit("pushq %rax");
-    TypeInfo right = e->right->accept(this);
-    string tipo = getDominantType(right.tipo,left.tipo);
+    TypeInfo right = dispatch(e->right);
+    Tipo tipo = getDominantType(right.tipo,left.tipo);
     emit_op("mov", "rax", "rcx", tipo);
     emit_convert("rcx", right.tipo, tipo);
     emit("popq %rax");
@@ -707,39 +802,37 @@ TypeInfo CodeGenVisitor::visit(BinaryExp* e) {
         case NE_OP:    emit("cmpq %rcx, %rax"); emit("movl $0, %eax"); emit("setne %al"); emit("movzbq %al, %rax"); break;
     }
     if(left.esTipoSinSigno() || right.esTipoSinSigno() ){
-        string k = "";
-        if(left.tipo == "long unsigned" || right.tipo == "long unsigned"){k = left.tipo;}
-        else{k = "unsigned";}
-        return TypeInfo(k, right.valor + left.valor, true);
+        return TypeInfo(TIPO_UNSIGNED, right.valor + left.valor, true);
     }
     return TypeInfo(tipo, 0, false);
 }
 
 TypeInfo CodeGenVisitor::visit(FCallExp* e) {
     std::vector<std::string> argRegs = {"%rdi", "%rsi", "%rdx", "%rcx", "%r8", "%r9"};
-    if (e->nombre == "printf") {
-        return TypeInfo("int", 0, false);
+    std::string nombre(simbolos.name(e->nombre));
+    if (nombre == "printf") {
+        return TypeInfo(TIPO_INT, 0, false);
     }
     for (int i = 0; i < e->argumentos.size(); i++) {
-        e->argumentos[i]->accept(this);
+        dispatch(e->argumentos[i]);
         emit("movq %rax, " + argRegs[i]);
     }
-    emit("call " + e->nombre);
-    if (functionReturnTypes.count(e->nombre)) {
-        return functionReturnTypes[e->nombre];
+    emit("call " + nombre);
+    if (e->tipoRetorno != TIPO_NINGUNO) {
+        return e->tipoRetorno;
     }
-    return TypeInfo("int", 0, false);
+    return TypeInfo(TIPO_INT, 0, false);
 }
 
 void CodeGenVisitor::visit(ExpressionStatement* s) {
     if (s->expr) {
-        TypeInfo result = s->expr->accept(this);
+        TypeInfo result = dispatch(s->expr);
     }
 }
 
 void CodeGenVisitor::visit(ReturnStatement* s) {
     if (s->e) {
-        TypeInfo ret = s->e->accept(this);
+        TypeInfo ret = dispatch(s->e);
         emit("movq %rax, %r15");
     }
     emit("jmp .end_" + nombreFuncion);
@@ -749,18 +842,18 @@ void CodeGenVisitor::visit(IfStatement* s) {
     int label = labelcont++;
     std::string elseLabel = "else_" + std::to_string(label);
     std::string endLabel = "endif_" + std::to_string(label);
-    s->condition->accept(this);
+    dispatch(s->condition);
     emit("cmpq $0, %rax");
     if (s->els) {
         emit("je " + elseLabel);
     } else {
         emit("je " + endLabel);
     }
-    if (s->then) s->then->accept(this);
+    if (s->then) visit(s->then);
     if (s->els) emit("jmp " + endLabel);
     if (s->els) {
         emit_label(elseLabel);
-        s->els->accept(this);
+        visit(s->els);
     }
     emit_label(endLabel);
 }
@@ -770,115 +863,86 @@ void CodeGenVisitor::visit(WhileStatement* s) {
     std::string whileLabel = "while_" + std::to_string(label);
     std::string endwhileLabel = "endwhile_" + std::to_string(label);
     emit_label(whileLabel);
-    s->condition->accept(this);
+    dispatch(s->condition);
     emit("cmpq $0, %rax");
     emit("je " + endwhileLabel);
-    if (s->b) s->b->accept(this);
+    if (s->b) visit(s->b);
     emit("jmp " + whileLabel);
     emit_label(endwhileLabel);
 }
 
 void CodeGenVisitor::visit(ForStatement* s) {
-    auto memoriaAnt     = memoria;
-    auto tiposAnt       = tiposVariables;
-    int  offsetAnt      = offset;
-    if (s->varInit) s->varInit->accept(this);
-    if (s->init)    s->init->accept(this);
+    if (s->varInit) visit(s->varInit);
+    if (s->init)    dispatch(s->init);
     int label = labelcont++;
     std::string forLabel    = "for_"    + std::to_string(label);
     std::string endforLabel = "endfor_" + std::to_string(label);
     emit_label(forLabel);
     if (s->cond) {
-        s->cond->accept(this);
+        dispatch(s->cond);
         emit("cmpq $0, %rax");
         emit("je " + endforLabel);
     }
-    if (s->body)   s->body->accept(this);
-    if (s->update) s->update->accept(this);
+    if (s->body)   visit(s->body);
+    if (s->update) dispatch(s->update);
     emit("jmp " + forLabel);
     emit_label(endforLabel);
-    memoria        = memoriaAnt;
-    tiposVariables = tiposAnt;
-    offset         = offsetAnt;
 }
 
 void CodeGenVisitor::visit(Body* b) {
     for (Stm* stm : b->stms) {
-        stm->accept(this);
+        dispatch(stm);
     }
 }
 
-void CodeGenVisitor::second_pass(Program* program) {
-    memoria.clear();
-    tiposVariables.clear();
-    offset = 0;
-    labelcont = 0;
-    entornoFuncion = false;
-    program->accept(this);
+void CodeGenVisitor::visit(Program* p) {
+    generarParalelo(p, 1);
 }
 
-void CodeGenVisitor::visit(Program* p) {
-    if (!firstPass) out << ".text\n";
-    for (FunDec* f : p->Fundecs)
-        f->accept(this);
+void CodeGenVisitor::generarMain(Program* p) {
     if (p->mainBody) {
         entornoFuncion = true;
-        memoria.clear();
-        tiposVariables.clear();
         nombreFuncion = "main";
-        if (!firstPass) {
-            out << ".globl main\n";
-            emit_label("main");
-            emit("pushq %rbp");
-            emit("movq %rsp, %rbp");
-            int nLocalsMain = countVarDecsInBody(p->mainBody);
-            if (nLocalsMain > 0) {
-                out << "    subq $" << (nLocalsMain * 8) << ", %rsp\n";
-            }
+        out << ".globl main\n";
+        emit_label("main");
+        emit("pushq %rbp");
+        emit("movq %rsp, %rbp");
+        int nLocalsMain = p->resumenMain.locales;
+        if (nLocalsMain > 0) {
+            out << "    subq $" << (nLocalsMain * 8) << ", %rsp\n";
         }
-        offset = 0;
         for (Stm* s : p->mainBody->stms)
-            s->accept(this);
+            dispatch(s);
         emit_label(".end_main");
         emit("movl $0, %eax");
         emit("leave");
         emit("ret");
         entornoFuncion = false;
     }
-    if (!firstPass)
-        out << ".section .note.GNU-stack,\"\",@progbits\n";
 }
 
 void CodeGenVisitor::visit(FunDec* f) {
     entornoFuncion = true;
-    memoria.clear();
-    tiposVariables.clear();
-    offset = 0;
-    nombreFuncion = f->nombre;
-    functionReturnTypes[f->nombre] = f->tipo;
-    emit_label(f->nombre);
+    nombreFuncion = std::string(simbolos.name(f->nombre));
+    TRAZA(CODEGEN, INFO, "función " << nombreFuncion << ", "
+                         << f->resumen.locales << " locales");
+    emit_label(nombreFuncion);
     emit("pushq %rbp");
     emit("movq %rsp, %rbp");
-    if (!firstPass) {
-        int nLocals = countVarDecsInBody(f->cuerpo) + f->parametros.size();
-        if (nLocals > 0) {
-            out << "    subq $" << (nLocals * 8) << ", %rsp\n";
-        }
+    int nLocals = f->resumen.locales + f->parametros.size();
+    if (nLocals > 0) {
+        out << "    subq $" << (nLocals * 8) << ", %rsp\n";
     }
     static const std::vector<std::string> argRegs = {
         "%rdi","%rsi","%rdx","%rcx","%r8","%r9"
     };
-    for (int i = 0; i < (int)f->parametros.size(); ++i) {
-        offset-=8;
-        memoria[f->parametros[i]] = offset;
-        tiposVariables[f->parametros[i]] = f->tipos[i];
-        emit("movq " + argRegs[i] + ", " + std::to_string(memoria[f->parametros[i]]) + "(%rbp)");
-    }
+    for (int i = 0; i < (int)f->parametros.size(); ++i)
+        emit("movq " + argRegs[i] + ", " + std::to_string(-8 * (i + 1)) + "(%rbp)");
     if (f->cuerpo) {
         for (Stm* s : f->cuerpo->stms)
-            s->accept(this);
+            dispatch(s);
     }
-    if (f->tipo == "void")
+    if (f->tipo == TIPO_VOID)
         emit("jmp .end_" + nombreFuncion);
     emit_label(".end_" + nombreFuncion);
     emit("movq %r15, %rax");
@@ -888,58 +952,117 @@ void CodeGenVisitor::visit(FunDec* f) {
 }
 
 void CodeGenVisitor::visit(VarDec* v) {
+    int slot = v->slot;
     for (auto const& p : v->vars) {
-        const std::string& name = p.first;
         Exp* init = p.second;
-        offset -= 8;
-        memoria[name] = offset;
-        tiposVariables[name] = v->tipo;
         if (init) {
-            TypeInfo ti = init->accept(this);
+            TypeInfo ti = dispatch(init);
             emit_truncation(ti.tipo, v->tipo);
-            if (ti.esNegativo() && TypeInfo(v->tipo).esTipoSinSigno())
+            if (ti.esNegativo() && esSinSigno(v->tipo))
                 emit_unsigned_conversion(ti.valor, v->tipo);
-            emit("movq %rax, " + std::to_string(memoria[name]) + "(%rbp)");
+            emit("movq %rax, " + std::to_string(slot) + "(%rbp)");
         } else {
-            emit("movq $0, " + std::to_string(memoria[name]) + "(%rbp)");
+            emit("movq $0, " + std::to_string(slot) + "(%rbp)");
         }
+        slot -= 8;
     }
 }
 
 void CodeGenVisitor::generar(Program* program) {
-    first_pass(program);
-    generate_used_formats();
-    second_pass(program);
+    generarParalelo(program, 1);
 }
 
-void CodeGenVisitor::first_pass(Program* program) {
+// Una sola pasada: cada función se arma en su buffer mientras se juntan sus formatos de
+// printf, y al final se escribe el .data seguido de los buffers.
+void CodeGenVisitor::generarParalelo(Program* p, unsigned hilos) {
+    struct Fragmento {
+        std::string texto;
+        std::vector<FormatoPrintf> formatos;
+    };
+    size_t n = p->Fundecs.size();
+    std::vector<Fragmento> fragmentos(n + 1);  // main al final
+
+    // Cada función numera sus etiquetas desde donde terminaron las de las anteriores,
+    // como si se generaran todas seguidas.
+    std::vector<int> primeraEtiqueta(n + 1);
+    int etiquetas = 0;
+    for (size_t i = 0; i < n; ++i) {
+        primeraEtiqueta[i] = etiquetas;
+        etiquetas += p->Fundecs[i]->resumen.etiquetas;
+    }
+    primeraEtiqueta[n] = etiquetas;
+
+    std::vector<std::unique_ptr<CodeGenVisitor>> trabajadores;
+    for (unsigned h = 0; h < std::max(1u, std::min<unsigned>(hilos, n + 1)); ++h)
+        trabajadores.push_back(std::unique_ptr<CodeGenVisitor>(new CodeGenVisitor(*this)));
+    paraleloPara(n + 1, hilos, [&](size_t i, unsigned h) {
+        CodeGenVisitor& c = *trabajadores[h];
+        c.out.str("");
+        c.formatosUsados.clear();
+        c.formatosVistos = 0;
+        c.labelcont = primeraEtiqueta[i];
+        if (i < n) c.visit(p->Fundecs[i]);
+        else c.generarMain(p);
+        fragmentos[i].texto = c.out.str();
+        fragmentos[i].formatos.swap(c.formatosUsados);
+    });
+
     formatosUsados.clear();
-    firstPass = true;
-    program->accept(this);
-    firstPass = false;
-}
-
-void CodeGenVisitor::emit_convert(const std::string& reg, const std::string& from_type, const std::string& to_type) {
-    if (firstPass || from_type == to_type) return;
-    out << "    # Converting " << reg << " from " << from_type << " to " << to_type << "\n";
-    if (from_type == "int" && to_type == "long") {
-        if (reg == "rax") out << "    movslq %eax, %rax\n";
-        else if (reg == "rcx") {
-            out << "    movl %ecx, %ecx\n";
-            out << "    movslq %ecx, %rcx\n";
+    formatosVistos = 0;
+    for (const Fragmento& f : fragmentos) {
+        for (FormatoPrintf formato : f.formatos) {
+            if (!(formatosVistos & (1u << formato))) {
+                formatosVistos |= 1u << formato;
+                formatosUsados.push_back(formato);
+                TRAZA(CODEGEN, INFO, "formato de printf %" << textoFormato[formato]);
+            }
         }
-    } else if (from_type == "unsigned" && to_type == "long") {
-        if (reg == "rax") out << "    movl %eax, %eax\n";
-        else if (reg == "rcx") out << "    movl %ecx, %ecx\n";
-    } else if (from_type == "long" && to_type == "int") {
-        if (reg == "rax") out << "    movl %eax, %eax\n";
-        else if (reg == "rcx") out << "    movl %ecx, %ecx\n";
-    } else if (from_type == "unsigned long" && to_type == "unsigned") {
-        if (reg == "rax") out << "    movl %eax, %eax\n";
-        else if (reg == "rcx") out << "    movl %ecx, %ecx\n";
-    } else if (from_type == "unsigned" && to_type == "unsigned long") {
-        if (reg == "rax") out << "    movl %eax, %eax\n";
-        else if (reg == "rcx") out << "    movl %ecx, %ecx\n";
+    }
+    generate_used_formats();
+    destino << ".text\n";
+    for (const Fragmento& f : fragmentos) destino << f.texto;
+    destino << ".section .note.GNU-stack,\"\",@progbits\n";
+}
+
+void CodeGenVisitor::iniciarFlujo() {
+    formatosUsados.clear();
+    formatosVistos = 0;
+    labelcont = 0;
+    entornoFuncion = false;
+    destino << ".text\n";
+}
+
+void CodeGenVisitor::generarEnFlujo(FunDec* f) {
+    out.str("");
+    visit(f);
+    destino << out.rdbuf();
+}
+
+void CodeGenVisitor::terminarFlujo(Program* p) {
+    out.str("");
+    generarMain(p);
+    destino << out.rdbuf();
+    generate_used_formats();
+    destino << ".section .note.GNU-stack,\"\",@progbits\n";
+}
+
+void CodeGenVisitor::emit_convert(const std::string& reg, Tipo from_type, Tipo to_type) {
+    if (from_type == to_type) return;
+    out << "    # Converting " << reg << " from " << nombreTipo(from_type) << " to " << nombreTipo(to_type) << "\n";
+    switch (conversionEntre(from_type, to_type)) {
+        case CONV_EXTENDER_SIGNO:
+            if (reg == "rax") out << "    movslq %eax, %rax\n";
+            else if (reg == "rcx") {
+                out << "    movl %ecx, %ecx\n";
+                out << "    movslq %ecx, %rcx\n";
+            }
+            break;
+        case CONV_CEROS_32:
+            if (reg == "rax") out << "    movl %eax, %eax\n";
+            else if (reg == "rcx") out << "    movl %ecx, %ecx\n";
+            break;
+        case CONV_NINGUNA:
+            break;
     }
 }
 
@@ -4,11 +4,22 @@
 #include <unordered_map>
 #include <string>
 #include <unordered_set>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <sstream>
 
 #include "env.h"
+#include "arena.h"
+#include "symbols.h"
+#include "types.h"
+#include "diagnosticos.h"
 
 
 struct TypeInfo;
+class Exp;
+class Stm;
 class UnaryExp;
 class BinaryExp;
 class NumberExp;
@@ -25,22 +36,16 @@ class ReturnStatement;
 class Program;
 class ExpressionStatement;
 
+// Interfaz con despacho virtual (Exp::accept -> Visitor::visit). Los dos visitors del
+// compilador la implementan, pero entre ellos recorren el árbol con StaticVisitor.
 class Visitor {
 public:
     virtual ~Visitor() {}
 
-    std::unordered_map<std::string, std::string> mapaFormatoATipo = {
-        {"d", "int"},
-        {"u", "unsigned"},
-        {"ld", "long"},
-        {"lu", "unsignedl"}
-    };
-
-
     std::string aceptados = "%d %u %ld %lu";
 
 
-    bool esTruncamientoPeligroso(const TypeInfo& from, const std::string& to);
+    bool esTruncamientoPeligroso(const TypeInfo& from, Tipo to);
     virtual TypeInfo visit(UnaryExp* e) = 0;
     virtual TypeInfo visit(BinaryExp* e) = 0;
     virtual TypeInfo visit(NumberExp* e) = 0;
@@ -58,26 +63,103 @@ public:
     virtual void visit(ExpressionStatement* s) = 0;
 };
 
-class TypeCheckerVisitor : public Visitor {
+// Despacho estático: dispatch hace un switch sobre la etiqueta del nodo y llama a
+// Derived::visit con el tipo concreto, sin pasar por accept ni por la vtable. Con
+// Derived final el compilador puede expandir los visit en línea. Las definiciones
+// están al final de exp.h, donde los nodos ya son tipos completos.
+template <typename Derived>
+class StaticVisitor {
+public:
+    TypeInfo dispatch(Exp* e);
+    void dispatch(Stm* s);
+};
+
+class TypeCheckerVisitor final : public Visitor, public StaticVisitor<TypeCheckerVisitor> {
 private:
+    // Datos de una función declarada; se guardan en un arreglo indexado por su Symbol.
+    struct FunctionInfo {
+        bool declarada = false;
+        Tipo tipoRetorno = TIPO_NINGUNO;
+        ArenaList<Tipo> tiposParametros;
+        bool retornaConstante = false;
+        int valorRetorno = 0;
+        int indice = -1;  // posición en el orden de definición
+    };
 
-    Environment<TypeInfo> env;  
-    std::unordered_map<std::string, std::string> functionReturnTypes;
-    std::string currentFunctionType;
-    std::unordered_map<std::string, std::vector<std::string>> functionParamTypes;
-    std::unordered_map<std::string, TypeInfo> functionReturnValues;
+    // Lo que se sabe de una variable visible: su tipo y valor (si es constante) y el
+    // offset que le toca en el frame. Se define en exp.h, después de TypeInfo.
+    struct Variable;
+
+    const SymbolTable& simbolos;
+    Diagnosticos& salida;
+    Diagnosticos* diagnosticos;         // salida, o el buffer de la función que se está chequeando
+    TypeCheckerVisitor* raiz;           // dueño de las firmas; this salvo en los hilos de chequearParalelo
+    Environment<Variable, Symbol> env;  
+    std::vector<FunctionInfo> funciones;
+    // Solo en la raíz: por índice de función (main al final), si su cuerpo ya se chequeó.
+    std::unique_ptr<std::atomic<bool>[]> terminadas;
+    std::mutex mutexTerminadas;
+    std::condition_variable cvTerminadas;
+    // Solo en la raíz: diagnósticos de cada función (main al final) hasta que se juntan en
+    // salida (nulo si no hay ninguno), y si su cuerpo se chequea.
+    std::vector<std::unique_ptr<Diagnosticos>> porFuncion;
+    std::vector<char> conCuerpo;
+    int indiceActual = 0;
+    Tipo currentFunctionType = TIPO_NINGUNO;
     bool hasStdio = false;
     int errorCount = 0;
     int warningCount = 0;
     bool hasReturn = false;
     std::string currentFunctionName;
+    Symbol currentFunction = NO_SYMBOL;
+    uint32_t posActual = SIN_POSICION;  // sentencia o función que se está chequeando
+    int offsetFrame = 0;                // último offset asignado en el frame de la función
+    bool enCodigoMuerto = false;        // anotando un bloque que nunca se ejecuta
+
+    std::string nombre(Symbol s) const { return std::string(simbolos.name(s)); }
+    FunctionInfo* funcion(Symbol s) {
+        std::vector<FunctionInfo>& fs = raiz->funciones;
+        return s < fs.size() && fs[s].declarada ? &fs[s] : nullptr;
+    }
+    void anotarMuerto(Body* b);
+    bool registrarFirma(FunDec* f);
+    void chequearCuerpo(FunDec* f);
+    void chequearMain(Program* p, int indice);
+    void esperarCuerpo(int indice);
+    void marcarTerminada(int indice);
+
+    // Hilo de chequearParalelo: comparte las firmas con la raíz.
+    explicit TypeCheckerVisitor(TypeCheckerVisitor& padre)
+        : simbolos(padre.simbolos), salida(padre.salida), diagnosticos(&padre.salida), raiz(&padre) {}
 
 public:
+    // Los errores y advertencias van a `diag`; el driver los muestra al final.
+    TypeCheckerVisitor(const SymbolTable& tabla, Diagnosticos& diag)
+        : simbolos(tabla), salida(diag), diagnosticos(&diag), raiz(this) {}
+
+    // Chequeo en dos fases: primero registra las firmas de todas las funciones (así se
+    // puede llamar a una función definida más abajo) y después chequea los cuerpos en
+    // `hilos` hilos, cada uno con su entorno. Una llamada a una función anterior espera a
+    // que esa termine y ve su valor de retorno, igual que en orden; de las posteriores solo
+    // se usa la firma. Los diagnósticos de cada función se juntan en orden de definición,
+    // así que la salida es la misma con cualquier cantidad de hilos. visit(Program*) es
+    // chequearParalelo(p, 1).
+    void chequearParalelo(Program* p, unsigned hilos);
+
+    // Modo flujo. registrarFirmas es la primera fase de chequearParalelo, sobre un Program
+    // sin cuerpos (el que arma un Parser con saltarCuerpos(true) mediante parseIncludes,
+    // parseFunctionRecuperando y parseFinal; ver Compilador::compilarEnFlujo). Después
+    // chequearEnFlujo(i, f) chequea el cuerpo de la función i en cuanto se parsea, y
+    // chequearEnFlujo(cantidad de funciones, nullptr, p) el de main. Los diagnósticos salen
+    // en el mismo orden que con chequearParalelo.
+    void registrarFirmas(Program* p);
+    void chequearEnFlujo(size_t i, FunDec* f, Program* p = nullptr);
+
     int getErrorCount() const { return errorCount; }
     int getWarningCount() const { return warningCount; }
     bool hasStdioIncluded() const;
-    void warning(const std::string& msg, bool incluirFuncion);
-    void error(const std::string& msg, bool incluirFuncion);
+    void warning(CodigoDiagnostico codigo, const std::string& msg, bool incluirFuncion);
+    void error(CodigoDiagnostico codigo, const std::string& msg, bool incluirFuncion);
     void reset();
     void validatePrintf(PrintStatement* s);
 
@@ -99,36 +181,52 @@ public:
     void visit(ExpressionStatement* s)override;
 };
 
-class CodeGenVisitor : public Visitor {
+class CodeGenVisitor final : public Visitor, public StaticVisitor<CodeGenVisitor> {
 private:
-    std::ostream& out;
-    std::unordered_map<std::string, int> memoria;        
-    std::unordered_map<std::string, std::string> tiposVariables; 
-    std::unordered_map<std::string, std::string> functionReturnTypes;
-    std::unordered_set<std::string> formatosUsados;     
-    bool firstPass;                
-    int offset;
+    // Los offsets y tipos de las variables, los tipos de retorno y los formatos de printf
+    // ya vienen anotados en el AST por el chequeo de tipos.
+    std::ostream& destino;
+    std::stringstream out;         // código de la función en curso
+    const SymbolTable& simbolos;
+    std::vector<FormatoPrintf> formatosUsados;  // en orden de primer uso
+    unsigned formatosVistos = 0;   // bit por FormatoPrintf ya agregado a formatosUsados
     int labelcont;                 
     bool entornoFuncion;          
     std::string nombreFuncion;        
     void emit(const std::string& instruction);
     void emit_label(const std::string& label);
     std::string new_label(const std::string& prefix = "L");
-    void emit_truncation(const std::string& from_type, const std::string& to_type);
-    void emit_unsigned_conversion(long value, const std::string& target_type);
-    std::string get_printf_format(const std::string& tipo);
-    std::string get_printf_label(const std::string& tipo);
-    void register_printf_format(const std::string& tipo);
+    void emit_truncation(Tipo from_type, Tipo to_type);
+    void emit_unsigned_conversion(long value, Tipo target_type);
+    std::string get_printf_format(Tipo tipo);
+    std::string get_printf_label(Tipo tipo);
     void generate_used_formats();
-    void emit_convert(const std::string& reg, const std::string& from_type, const std::string& to_type);
-    void emit_op(const std::string& op, const std::string& a, const std::string& b, const std::string& tipo);
+    void emit_convert(const std::string& reg, Tipo from_type, Tipo to_type);
+    void emit_op(const std::string& op, const std::string& a, const std::string& b, Tipo tipo);
+    void generarMain(Program* p);
+
+    // Hilo de generarParalelo: escribe en su propio buffer.
+    explicit CodeGenVisitor(CodeGenVisitor& padre)
+        : destino(padre.destino), simbolos(padre.simbolos), labelcont(0), entornoFuncion(false) {}
 
 public:
-    CodeGenVisitor(std::ostream& output) : out(output), firstPass(false), offset(-8), labelcont(0), entornoFuncion(false) {}
+    CodeGenVisitor(std::ostream& output, const SymbolTable& tabla)
+        : destino(output), simbolos(tabla), labelcont(0), entornoFuncion(false) {}
     
     void generar(Program* program);
-    void first_pass(Program* program);  
-    void second_pass(Program* program); 
+    // Genera cada función (y main) en `hilos` hilos, cada una en su buffer y con sus
+    // etiquetas numeradas desde la suma de FunctionSummary::etiquetas de las anteriores.
+    // Los buffers y los formatos de printf se juntan en orden de definición, así que el
+    // .s es idéntico byte a byte con cualquier cantidad de hilos. generar es
+    // generarParalelo(program, 1).
+    void generarParalelo(Program* program, unsigned hilos);
+
+    // Modo flujo: iniciarFlujo abre el .text, generarEnFlujo escribe cada función en destino
+    // apenas la genera, y terminarFlujo escribe main, el .data y el cierre. Las etiquetas se
+    // numeran igual que en generar; solo cambia que el .data queda al final.
+    void iniciarFlujo();
+    void generarEnFlujo(FunDec* f);
+    void terminarFlujo(Program* p);
     
     TypeInfo visit(UnaryExp* e) override;
     TypeInfo visit(BinaryExp* e) override;
@@ -1,6 +1,14 @@
 from flask import Flask, render_template, request, send_file, jsonify
+import io
+import json
 import os
+import shlex
+import socket
+import struct
 import subprocess
+import tempfile
+import threading
+import time
 from werkzeug.utils import secure_filename
 
 app = Flask(__name__)
@@ -10,6 +18,13 @@ ALLOWED_EXTENSIONS = {'.c', '.txt'}
 
 app.config['UPLOAD_FOLDER'] = UPLOAD_FOLDER
 
+# El compilador queda corriendo como servidor (./programa --servidor, ver servidor.h) y se
+# le mandan los fuentes por este socket, en vez de lanzar un proceso por pedido.
+SOCKET_COMPILADOR = os.path.join(UPLOAD_FOLDER, 'compilador.sock')
+COMPILADO, ERROR_SINTAXIS, ERROR_TIPOS = 0, 1, 2
+_servidor = None
+_servidor_lock = threading.Lock()
+
 # Utilidades
 
 def allowed_file(filename):
@@ -22,6 +37,96 @@ def run_command(cmd, input_file=None):
     except Exception as e:
         return '', str(e), 1
 
+def _leer_exacto(s, n):
+    datos = b''
+    while len(datos) < n:
+        parte = s.recv(n - len(datos))
+        if not parte:
+            raise ConnectionError('el servidor de compilación cerró la conexión')
+        datos += parte
+    return datos
+
+def _leer_bloque(s):
+    largo, = struct.unpack('!I', _leer_exacto(s, 4))
+    return _leer_exacto(s, largo)
+
+def _conectar():
+    global _servidor
+    with _servidor_lock:
+        if _servidor is None or _servidor.poll() is not None:
+            _servidor = subprocess.Popen(['./programa', '--servidor=' + SOCKET_COMPILADOR], cwd=UPLOAD_FOLDER)
+    # Hasta que el servidor recién lanzado escucha, el socket no existe o es el que dejó
+    # uno anterior (y rechaza la conexión).
+    limite = time.monotonic() + 5
+    while True:
+        s = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        try:
+            s.connect(SOCKET_COMPILADOR)
+            return s
+        except (ConnectionRefusedError, FileNotFoundError):
+            s.close()
+            if time.monotonic() > limite:
+                raise
+            time.sleep(0.05)
+
+def compilar(code):
+    """Devuelve (assembly, None) si compiló, o (None, mensaje de error)."""
+    fuente = code.encode('utf-8')
+    try:
+        with _conectar() as s:
+            s.sendall(struct.pack('!I', len(fuente)) + fuente)
+            resultado, = struct.unpack('!I', _leer_exacto(s, 4))
+            asm = _leer_bloque(s).decode('utf-8')
+            diagnosticos = json.loads(_leer_bloque(s))
+    except (OSError, ConnectionError) as e:
+        return None, 'Error ejecutando el compilador: ' + str(e)
+    if resultado == COMPILADO:
+        return asm, None
+    # El mismo texto que imprime ./programa (Diagnosticos::escribirTexto)
+    lineas = []
+    for d in diagnosticos['diagnosticos']:
+        linea = 'Error: ' if d['severidad'] == 'error' else 'Advertencia: '
+        if d['funcion']:
+            linea += "En función '%s': " % d['funcion']
+        linea += d['mensaje']
+        if d['linea'] is not None:
+            linea += ' (línea %d)' % d['linea']
+        lineas.append(linea)
+    lineas.append('%d error(es) de sintaxis.' % diagnosticos['errores'] if resultado == ERROR_SINTAXIS
+                  else 'El chequeo de tipos falló.')
+    return None, '\n'.join(lineas)
+
+# Cada pedido ensambla y ejecuta en un directorio temporal propio, así dos pedidos a la
+# vez no se pisan los archivos.
+
+def ejecutar_mio(asm, tmp):
+    """Ensambla y ejecuta el assembly de nuestro compilador: (salida, None) o (None, error)."""
+    s_path = os.path.join(tmp, 'output.s')
+    exe = os.path.join(tmp, 'output')
+    with open(s_path, 'w') as f:
+        f.write(asm)
+    out, err, code_ = run_command('gcc -no-pie -o %s %s' % (shlex.quote(exe), shlex.quote(s_path)))
+    if code_ != 0:
+        return None, err or out or 'Error compilando output.s'
+    out, err, code_ = run_command(shlex.quote(exe))
+    if code_ != 0:
+        return None, err or out or 'Error ejecutando output'
+    return out, None
+
+def ejecutar_gcc(code, tmp):
+    """Compila con GCC y ejecuta: (salida, None) o (None, error)."""
+    c_path = os.path.join(tmp, 'temp_gcc.c')
+    exe = os.path.join(tmp, 'temp_gcc_exec')
+    with open(c_path, 'w') as f:
+        f.write(code)
+    out, err, code_ = run_command('gcc -O2 -o %s %s' % (shlex.quote(exe), shlex.quote(c_path)))
+    if code_ != 0:
+        return None, err or out or 'Error compilando con GCC'
+    out, err, code_ = run_command(shlex.quote(exe))
+    if code_ != 0:
+        return None, err or out or 'Error ejecutando GCC'
+    return out, None
+
 @app.route('/')
 def index():
     return render_template('index.html')
@@ -29,41 +134,30 @@ def index():
 @app.route('/compile', methods=['POST'])
 def compile_code():
     code = request.form['code']
-    with open('input.txt', 'w') as f:
-        f.write(code)
-    # Ejecutar el compilador
-    out, err, code_ = run_command('./programa')
-    if code_ != 0:
-        return jsonify({'error': err or out or 'Error ejecutando el compilador.'})
-    # Leer el .s generado
-    if not os.path.exists('output.s'):
-        return jsonify({'error': 'No se generó output.s'})
-    with open('output.s', 'r') as f:
-        asm = f.read()
+    asm, error = compilar(code)
+    if error:
+        return jsonify({'error': error})
     return jsonify({'asm': asm})
 
 @app.route('/run_s', methods=['POST'])
 def run_s():
-    # Compilar y ejecutar el .s
-    out, err, code_ = run_command('gcc -no-pie -o output output.s')
-    if code_ != 0:
-        return jsonify({'error': err or out or 'Error compilando output.s'})
-    out, err, code_ = run_command('./output')
-    if code_ != 0:
-        return jsonify({'error': err or out or 'Error ejecutando output'})
+    # Compilar (en memoria, por el servidor) y ejecutar el .s
+    asm, error = compilar(request.form['code'])
+    if error:
+        return jsonify({'error': error})
+    with tempfile.TemporaryDirectory() as tmp:
+        out, error = ejecutar_mio(asm, tmp)
+    if error:
+        return jsonify({'error': error})
     return jsonify({'output': out.strip()})
 
 @app.route('/run_gcc', methods=['POST'])
 def run_gcc():
     code = request.form['code']
-    with open('temp_gcc.c', 'w') as f:
-        f.write(code)
-    out, err, code_ = run_command('gcc -O2 -o temp_gcc_exec temp_gcc.c')
-    if code_ != 0:
-        return jsonify({'error': err or out or 'Error compilando con GCC'})
-    out, err, code_ = run_command('./temp_gcc_exec')
-    if code_ != 0:
-        return jsonify({'error': err or out or 'Error ejecutando GCC'})
+    with tempfile.TemporaryDirectory() as tmp:
+        out, error = ejecutar_gcc(code, tmp)
+    if error:
+        return jsonify({'error': error})
     return jsonify({'output': out.strip()})
 
 @app.route('/compare', methods=['POST'])
@@ -71,26 +165,17 @@ def compare():
     code = request.form['code']
     # Ejecutar ambos y comparar
     # 1. Compilar y ejecutar con tu compilador
-    with open('input.txt', 'w') as f:
-        f.write(code)
-    out, err, code_ = run_command('./programa')
-    if code_ != 0:
-        return jsonify({'error': err or out or 'Error ejecutando el compilador.'})
-    out, err, code_ = run_command('gcc -no-pie -o output output.s')
-    if code_ != 0:
-        return jsonify({'error': err or out or 'Error compilando output.s'})
-    out_mine, err, code_ = run_command('./output')
-    if code_ != 0:
-        return jsonify({'error': err or out_mine or 'Error ejecutando output'})
-    # 2. Compilar y ejecutar con GCC
-    with open('temp_gcc.c', 'w') as f:
-        f.write(code)
-    out, err, code_ = run_command('gcc -O2 -o temp_gcc_exec temp_gcc.c')
-    if code_ != 0:
-        return jsonify({'error': err or out or 'Error compilando con GCC'})
-    out_gcc, err, code_ = run_command('./temp_gcc_exec')
-    if code_ != 0:
-        return jsonify({'error': err or out_gcc or 'Error ejecutando GCC'})
+    asm, error = compilar(code)
+    if error:
+        return jsonify({'error': error})
+    with tempfile.TemporaryDirectory() as tmp:
+        out_mine, error = ejecutar_mio(asm, tmp)
+        if error:
+            return jsonify({'error': error})
+        # 2. Compilar y ejecutar con GCC
+        out_gcc, error = ejecutar_gcc(code, tmp)
+        if error:
+            return jsonify({'error': error})
     iguales = out_mine.strip() == out_gcc.strip()
     return jsonify({'mine': out_mine.strip(), 'gcc': out_gcc.strip(), 'ok': iguales})
 
@@ -107,11 +192,13 @@ def upload():
         return jsonify({'content': content})
     return jsonify({'error': 'Tipo de archivo no permitido.'})
 
-@app.route('/download_s')
+@app.route('/download_s', methods=['POST'])
 def download_s():
-    if not os.path.exists('output.s'):
-        return 'No se ha generado output.s', 404
-    return send_file('output.s', as_attachment=True)
+    asm, error = compilar(request.form['code'])
+    if error:
+        return error, 400
+    return send_file(io.BytesIO(asm.encode('utf-8')), as_attachment=True, download_name='output.s',
+                     mimetype='text/plain')
 
 if __name__ == '__main__':
     app.run(debug=True)